@@ -0,0 +1,564 @@
+/*
+ * bench.c - Headless benchmark of tui.h
+ *
+ * Every scenario builds a tree of windows and renders it a number of frames,
+ * changing something before every frame. The tui is rendered to /dev/null,
+ * with a terminal of BENCH_W x BENCH_H, and the report is written to stdout.
+ *
+ * Compile from the root of the repository:
+ *
+ *   gcc -O2 -o bench/bench bench/bench.c -lncurses
+ *
+ * Run every scenario, or only the scenarios that are named:
+ *
+ *   ./bench/bench [-f frames] [-c] [scenario ...]
+ *
+ * -c renders in composite mode
+ *
+ * The layout time, draws and allocations are averages per frame
+ */
+
+#define TUI_PROFILE
+#define TUI_IMPLEMENTATION
+#include "../tui.h"
+
+#include <stdio.h>
+
+#define BENCH_W 200
+#define BENCH_H 60
+
+/*
+ * Scenario struct
+ */
+typedef struct bench_t
+{
+  char* name;
+  void  (*init)  (tui_t* tui);
+  void  (*frame) (tui_t* tui, int index);
+} bench_t;
+
+/*
+ * Result struct, of one scenario
+ */
+typedef struct result_t
+{
+  double  fps;
+  int64_t p50;
+  int64_t p90;
+  int64_t p99;
+  int64_t max;
+  int64_t layout_time;
+  size_t  draw_count;
+  double  alloc_count;
+} result_t;
+
+static size_t seed = 1;
+
+/*
+ * Get pseudo random number, the same every run
+ */
+static int bench_rand(void)
+{
+  seed = seed * 1103515245 + 12345;
+
+  return (seed >> 16) & 0x7fff;
+}
+
+static tui_window_text_t*  texts[1024];
+static size_t              text_count = 0;
+
+static tui_window_grid_t*  grid = NULL;
+
+static tui_input_t*        inputs[64];
+static size_t              input_count = 0;
+
+static tui_list_t*         list = NULL;
+
+static char                long_strings[2][16384];
+
+/*
+ * Deep: parents nested inside each other, with a text at the bottom
+ */
+static void deep_init(tui_t* tui)
+{
+  tui_window_parent_t* parent = tui_window_parent_create(tui, (tui_window_parent_config_t)
+  {
+    .name   = "deep",
+    .rect   = TUI_PARENT_RECT,
+    .color  = { .bg = TUI_COLOR_BLUE },
+    .border = { .is_active = true }
+  });
+
+  for (int depth = 0; depth < 28; depth++)
+  {
+    parent = tui_parent_child_parent_create(parent, (tui_window_parent_config_t)
+    {
+      .name        = "deep",
+      .rect        = TUI_RECT_NONE,
+      .w_grow      = true,
+      .h_grow      = true,
+      .is_vertical = depth % 2,
+      .color       = { .bg = 1 + depth % 16 },
+      .border      = { .is_active = (depth % 3 == 0) }
+    });
+  }
+
+  texts[text_count++] = tui_parent_child_text_create(parent, (tui_window_text_config_t)
+  {
+    .name   = "leaf",
+    .string = "leaf",
+    .rect   = TUI_RECT_NONE,
+    .align  = TUI_ALIGN_CENTER,
+    .pos    = TUI_POS_CENTER
+  });
+}
+
+/*
+ * Deep: change the text at the bottom
+ */
+static void deep_frame(tui_t* tui, int index)
+{
+  (void) tui;
+
+  tui_window_text_string_set(texts[0], (index % 2) ? "leaf" : "other leaf");
+}
+
+/*
+ * Wide: one parent with many texts
+ */
+static void wide_init(tui_t* tui)
+{
+  tui_window_parent_t* parent = tui_window_parent_create(tui, (tui_window_parent_config_t)
+  {
+    .name     = "wide",
+    .rect     = TUI_PARENT_RECT,
+    .color    = { .bg = TUI_COLOR_BLUE },
+    .align    = TUI_ALIGN_BETWEEN,
+    .has_gap  = true
+  });
+
+  for (int index = 0; index < 800; index++)
+  {
+    texts[text_count++] = tui_parent_child_text_create(parent, (tui_window_text_config_t)
+    {
+      .name   = "item",
+      .string = (index % 3) ? "item" : "other item",
+      .rect   = TUI_RECT_NONE,
+      .color  = { .bg = 1 + index % 16 }
+    });
+  }
+}
+
+/*
+ * Wide: change one text, which changes the layout of the parent
+ */
+static void wide_frame(tui_t* tui, int index)
+{
+  (void) tui;
+
+  tui_window_text_t* text = texts[bench_rand() % text_count];
+
+  tui_window_text_string_set(text, (index % 2) ? "item" : "longer item");
+}
+
+/*
+ * Grid: grid that covers the screen
+ */
+static void grid_init(tui_t* tui)
+{
+  tui_window_parent_t* parent = tui_window_parent_create(tui, (tui_window_parent_config_t)
+  {
+    .name  = "grid",
+    .rect  = TUI_PARENT_RECT,
+    .color = { .bg = TUI_COLOR_BLACK }
+  });
+
+  grid = tui_parent_child_grid_create(parent, (tui_window_grid_config_t)
+  {
+    .name = "grid",
+    .rect = TUI_PARENT_RECT,
+    .size = { .w = BENCH_W, .h = BENCH_H }
+  });
+
+  for (int y = 0; y < BENCH_H; y++)
+  {
+    for (int x = 0; x < BENCH_W; x++)
+    {
+      tui_window_grid_square_set(grid, x, y, (tui_window_grid_square_t)
+      {
+        .symbol = 'a' + (x + y) % 26,
+        .color  = { .fg = 1 + x % 16, .bg = 1 + y % 16 }
+      });
+    }
+  }
+}
+
+/*
+ * Grid: change random squares
+ */
+static void grid_frame(tui_t* tui, int index)
+{
+  (void) tui;
+
+  for (int count = 0; count < 200; count++)
+  {
+    int x = bench_rand() % BENCH_W;
+    int y = bench_rand() % BENCH_H;
+
+    tui_window_grid_square_set(grid, x, y, (tui_window_grid_square_t)
+    {
+      .symbol = 'A' + index % 26,
+      .color  = { .fg = 1 + index % 16, .bg = 1 + count % 16 }
+    });
+  }
+}
+
+/*
+ * Text: long wrapped text with colors, that covers the screen
+ */
+static void text_init(tui_t* tui)
+{
+  for (int string = 0; string < 2; string++)
+  {
+    size_t length = 0;
+
+    while (length < sizeof(long_strings[string]) - 64)
+    {
+      length += sprintf(long_strings[string] + length, "\033[3%dmword%d\033[0m lorem ipsum ", (int) length % 8, string);
+    }
+  }
+
+  tui_window_parent_t* parent = tui_window_parent_create(tui, (tui_window_parent_config_t)
+  {
+    .name  = "text",
+    .rect  = TUI_PARENT_RECT,
+    .color = { .bg = TUI_COLOR_BLACK, .fg = TUI_COLOR_WHITE }
+  });
+
+  texts[text_count++] = tui_parent_child_text_create(parent, (tui_window_text_config_t)
+  {
+    .name   = "text",
+    .string = long_strings[0],
+    .rect   = TUI_RECT_NONE,
+    .w_grow = true,
+    .h_grow = true
+  });
+}
+
+/*
+ * Text: change the whole text
+ */
+static void text_frame(tui_t* tui, int index)
+{
+  (void) tui;
+
+  tui_window_text_string_set(texts[0], long_strings[index % 2]);
+}
+
+/*
+ * Inputs: list of input windows
+ */
+static void inputs_init(tui_t* tui)
+{
+  tui_window_parent_t* parent = tui_window_parent_create(tui, (tui_window_parent_config_t)
+  {
+    .name        = "inputs",
+    .rect        = TUI_PARENT_RECT,
+    .is_vertical = true,
+    .color       = { .bg = TUI_COLOR_BLUE }
+  });
+
+  list = tui_list_create(tui, true);
+
+  for (int index = 0; index < 48; index++)
+  {
+    tui_window_text_t* window = tui_parent_child_text_create(parent, (tui_window_text_config_t)
+    {
+      .name        = "input",
+      .string      = "",
+      .rect        = TUI_RECT_NONE,
+      .w_grow      = true,
+      .is_interact = true,
+      .color       = { .bg = TUI_COLOR_BLACK, .fg = TUI_COLOR_WHITE }
+    });
+
+    inputs[input_count++] = tui_input_create(tui, 180, window);
+
+    tui_list_item_add(list, (tui_window_t*) window);
+  }
+
+  tui_window_set(tui, list->items[0]);
+}
+
+/*
+ * Inputs: type in the selected input, and sometimes select the next
+ */
+static void inputs_frame(tui_t* tui, int index)
+{
+  if (index % 16 == 15)
+  {
+    if (!tui_list_event(list, KEY_DOWN))
+    {
+      list->item_index = 0;
+    }
+
+    tui_window_set(tui, list->items[list->item_index]);
+  }
+
+  tui_input_t* input = inputs[list->item_index];
+
+  if (input->buffer_len >= input->buffer_size)
+  {
+    while (tui_input_event(input, KEY_BACKSPACE));
+  }
+
+  tui_input_event(input, 'a' + index % 26);
+
+  tui_window_text_string_set(input->window, input->string);
+}
+
+/*
+ * List: set row of virtual list to its item, and mark the selected item
+ */
+static void list_row(tui_list_t* list, tui_window_text_t* row, size_t index)
+{
+  char string[64];
+
+  sprintf(string, "%s item %zu", (index == list->item_index) ? ">" : " ", index);
+
+  tui_window_text_string_set(row, string);
+}
+
+/*
+ * List: virtual list of 50000 items
+ */
+static void list_init(tui_t* tui)
+{
+  tui_window_parent_t* parent = tui_window_parent_create(tui, (tui_window_parent_config_t)
+  {
+    .name        = "list",
+    .rect        = TUI_PARENT_RECT,
+    .is_vertical = true,
+    .color       = { .bg = TUI_COLOR_BLUE }
+  });
+
+  list = tui_list_virtual_create(tui, parent, 50000, list_row);
+}
+
+/*
+ * List: scroll down, and sometimes a page down
+ */
+static void list_frame(tui_t* tui, int index)
+{
+  (void) tui;
+
+  int key = (index % 8 == 7) ? KEY_NPAGE : KEY_DOWN;
+
+  if (!tui_list_event(list, key))
+  {
+    list->item_index = 0;
+
+    tui_list_update(list);
+  }
+}
+
+/*
+ * Resize: deep and wide tree, in a terminal that changes size
+ */
+static void resize_init(tui_t* tui)
+{
+  deep_init(tui);
+
+  wide_init(tui);
+}
+
+/*
+ * Resize: change the size of the terminal
+ */
+static void resize_frame(tui_t* tui, int index)
+{
+  (void) tui;
+
+  resizeterm(BENCH_H - index % 2, BENCH_W - index % 2);
+}
+
+static bench_t benches[] =
+{
+  { "deep",   deep_init,   deep_frame   },
+  { "wide",   wide_init,   wide_frame   },
+  { "grid",   grid_init,   grid_frame   },
+  { "text",   text_init,   text_frame   },
+  { "inputs", inputs_init, inputs_frame },
+  { "list",   list_init,   list_frame   },
+  { "resize", resize_init, resize_frame }
+};
+
+/*
+ * Compare latencies, for qsort
+ */
+static int latency_compare(const void* a, const void* b)
+{
+  int64_t first  = *(const int64_t*) a;
+  int64_t second = *(const int64_t*) b;
+
+  return (first > second) - (first < second);
+}
+
+/*
+ * Run scenario and get result
+ */
+static result_t bench_run(bench_t* bench, int frames, bool is_composite)
+{
+  result_t result = { 0 };
+
+  seed = 1;
+
+  text_count  = 0;
+  input_count = 0;
+
+  tui_t* tui = tui_create((tui_config_t)
+  {
+    .color        = { .bg = TUI_COLOR_BLACK, .fg = TUI_COLOR_WHITE },
+    .is_composite = is_composite
+  });
+
+  if (!tui)
+  {
+    return result;
+  }
+
+  resizeterm(BENCH_H, BENCH_W);
+
+  bench->init(tui);
+
+  tui_render(tui);
+
+  tui_present(tui);
+
+  // Only the frames are measured, not building the windows
+  tui_stats_reset(tui);
+
+  int64_t* latencies = malloc(sizeof(int64_t) * frames);
+
+  int64_t start = tui_time_us_get();
+
+  for (int index = 0; index < frames; index++)
+  {
+    bench->frame(tui, index);
+
+    int64_t frame_start = tui_time_us_get();
+
+    tui_render(tui);
+
+    tui_present(tui);
+
+    latencies[index] = tui_time_us_get() - frame_start;
+
+    result.layout_time += tui->stats.size_time + tui->stats.rect_time;
+    result.draw_count  += tui->stats.draw_count;
+    result.alloc_count += tui->stats.alloc_count;
+  }
+
+  int64_t time = tui_time_us_get() - start;
+
+  qsort(latencies, frames, sizeof(int64_t), latency_compare);
+
+  result.fps = frames / (MAX(1, time) / 1000000.0);
+  result.p50 = latencies[frames * 50 / 100];
+  result.p90 = latencies[frames * 90 / 100];
+  result.p99 = latencies[frames * 99 / 100];
+  result.max = latencies[frames - 1];
+
+  result.layout_time /= frames;
+  result.draw_count  /= frames;
+  result.alloc_count /= frames;
+
+  free(latencies);
+
+  for (size_t index = 0; index < input_count; index++)
+  {
+    tui_input_delete(&inputs[index]);
+  }
+
+  tui_list_delete(&list);
+
+  tui_delete(&tui);
+
+  return result;
+}
+
+/*
+ * Check if scenario is named in arguments, or if no scenario is named
+ */
+static bool bench_is_named(bench_t* bench, int argc, char** argv, int first)
+{
+  if (first >= argc) return true;
+
+  for (int index = first; index < argc; index++)
+  {
+    if (strcmp(argv[index], bench->name) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  int  frames       = 1000;
+  bool is_composite = false;
+
+  int first = 1;
+
+  for (; first < argc && argv[first][0] == '-'; first++)
+  {
+    if (strcmp(argv[first], "-f") == 0 && first + 1 < argc)
+    {
+      frames = atoi(argv[++first]);
+
+      frames = MAX(1, frames);
+    }
+    else if (strcmp(argv[first], "-c") == 0)
+    {
+      is_composite = true;
+    }
+  }
+
+  // The report is written to stdout, and the tui to /dev/null
+  FILE* report = fdopen(dup(STDOUT_FILENO), "w");
+
+  if (!report || !freopen("/dev/null", "w", stdout))
+  {
+    fprintf(stderr, "bench: failed to open /dev/null\n");
+
+    return 1;
+  }
+
+  setenv("TERM", "xterm-256color", 0);
+
+  fprintf(report, "tui.h bench: %d frames, %dx%d%s\n\n", frames, BENCH_W, BENCH_H, is_composite ? ", composite" : "");
+
+  fprintf(report, "%-8s %10s %8s %8s %8s %8s %10s %8s %8s\n",
+    "scenario", "fps", "p50 us", "p90 us", "p99 us", "max us", "layout us", "draws", "allocs");
+
+  for (size_t index = 0; index < sizeof(benches) / sizeof(bench_t); index++)
+  {
+    bench_t* bench = &benches[index];
+
+    if (!bench_is_named(bench, argc, argv, first)) continue;
+
+    result_t result = bench_run(bench, frames, is_composite);
+
+    fprintf(report, "%-8s %10.1f %8ld %8ld %8ld %8ld %10ld %8zu %8.2f\n",
+      bench->name, result.fps, (long) result.p50, (long) result.p90, (long) result.p99,
+      (long) result.max, (long) result.layout_time, result.draw_count, result.alloc_count);
+
+    fflush(report);
+  }
+
+  fclose(report);
+
+  return 0;
+}
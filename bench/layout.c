@@ -0,0 +1,326 @@
+/*
+ * layout.c - Headless check of the cached child layout of tui.h
+ *
+ * Every seed builds a random tree of windows and changes it before every frame,
+ * by hiding, showing, resizing and placing windows and changing texts.
+ * After some frames, the rects and visability of every window are compared
+ * with a layout calculated from scratch, where no child keeps its rect.
+ * The tui is rendered to /dev/null, and the report is written to stdout.
+ *
+ * Compile from the root of the repository:
+ *
+ *   gcc -O2 -o bench/layout bench/layout.c -lncurses
+ *
+ * Run the seeds from 1 to seeds:
+ *
+ *   ./bench/layout [-s seeds] [-f frames]
+ *
+ * The exit status is 1 if any layout differs
+ */
+
+#define TUI_IMPLEMENTATION
+#include "../tui.h"
+
+#include <stdio.h>
+
+#define LAYOUT_W 160
+#define LAYOUT_H 50
+
+// Frames between every comparison with a layout from scratch
+#define LAYOUT_CHECK 3
+
+#define WINDOW_MAX 4096
+
+/*
+ * Rect and visability of window
+ */
+typedef struct place_t
+{
+  bool       is_visable;
+  tui_rect_t rect;
+} place_t;
+
+static size_t seed = 1;
+
+/*
+ * Get pseudo random number, the same every run
+ */
+static int layout_rand(void)
+{
+  seed = seed * 1103515245 + 12345;
+
+  return (seed >> 16) & 0x7fff;
+}
+
+static tui_window_t* windows[WINDOW_MAX];
+static size_t        window_count = 0;
+
+static place_t       cached[WINDOW_MAX];
+
+static char* strings[] =
+{
+  "a", "bb", "hello world", "x y z w", "longer text that wraps around a bit", "", "ccc\nd"
+};
+
+#define STRING_COUNT (sizeof(strings) / sizeof(char*))
+
+/*
+ * Get random rect, or NONE rect for an aligned window
+ */
+static tui_rect_t layout_rect_get(int chance, int w, int h)
+{
+  if (layout_rand() % chance) return TUI_RECT_NONE;
+
+  return (tui_rect_t)
+  {
+    .x = layout_rand() % 5,
+    .y = layout_rand() % 5,
+    .w = 1 + layout_rand() % w,
+    .h = 1 + layout_rand() % h
+  };
+}
+
+/*
+ * Build random children of parent, and their children
+ */
+static void layout_build(tui_window_parent_t* parent, int depth)
+{
+  int count = 1 + layout_rand() % (depth ? 6 : 30);
+
+  for (int index = 0; index < count && window_count < WINDOW_MAX; index++)
+  {
+    if (depth < 3 && layout_rand() % 4 == 0)
+    {
+      tui_window_parent_t* child = tui_parent_child_parent_create(parent, (tui_window_parent_config_t)
+      {
+        .rect        = layout_rect_get(8, 10, 4),
+        .is_vertical = layout_rand() % 2,
+        .align       = layout_rand() % 6,
+        .pos         = layout_rand() % 3,
+        .has_gap     = layout_rand() % 2,
+        .has_padding = layout_rand() % 3 == 0,
+        .border      = { .is_active = layout_rand() % 3 == 0 },
+        .w_grow      = layout_rand() % 3 == 0,
+        .h_grow      = layout_rand() % 3 == 0,
+        .is_atomic   = layout_rand() % 4 == 0
+      });
+
+      if (!child) return;
+
+      windows[window_count++] = (tui_window_t*) child;
+
+      layout_build(child, depth + 1);
+    }
+    else
+    {
+      tui_window_text_t* child = tui_parent_child_text_create(parent, (tui_window_text_config_t)
+      {
+        .string     = strings[layout_rand() % STRING_COUNT],
+        .rect       = layout_rect_get(10, 6, 2),
+        .w_grow     = layout_rand() % 3 == 0,
+        .h_grow     = layout_rand() % 4 == 0,
+        .is_atomic  = layout_rand() % 3 == 0,
+        .is_contain = layout_rand() % 6 == 0
+      });
+
+      if (!child) return;
+
+      windows[window_count++] = (tui_window_t*) child;
+    }
+  }
+}
+
+/*
+ * Change random windows, and sometimes the size of the terminal
+ */
+static void layout_change(void)
+{
+  int count = 1 + layout_rand() % 4;
+
+  for (int index = 0; index < count; index++)
+  {
+    tui_window_t* window = windows[layout_rand() % window_count];
+
+    switch (layout_rand() % 6)
+    {
+      case 0:
+        window->is_hidden = !window->is_hidden;
+        break;
+
+      case 1: case 2:
+        if (window->type == TUI_WINDOW_TEXT)
+        {
+          tui_window_text_string_set((tui_window_text_t*) window, strings[layout_rand() % STRING_COUNT]);
+        }
+        break;
+
+      case 3:
+        window->rect = layout_rect_get(3, 10, 4);
+        break;
+
+      case 4:
+        if (layout_rand() % 4 == 0)
+        {
+          resizeterm(30 + layout_rand() % 30, 100 + layout_rand() % 60);
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+/*
+ * Get rect and visability of window
+ */
+static place_t layout_place_get(tui_window_t* window)
+{
+  return (place_t)
+  {
+    .is_visable = window->_is_visable,
+    .rect       = window->_is_visable ? window->_rect : TUI_RECT_NONE
+  };
+}
+
+/*
+ * Check if two places are equal
+ */
+static bool layout_place_is_equal(place_t a, place_t b)
+{
+  if (a.is_visable != b.is_visable) return false;
+
+  return !a.is_visable || tui_rect_is_equal(a.rect, b.rect);
+}
+
+/*
+ * Run seed, and get the amount of windows that differ from the layout from scratch
+ */
+static size_t layout_run(size_t run_seed, int frames, size_t* check_count)
+{
+  seed = run_seed;
+
+  window_count = 0;
+
+  tui_t* tui = tui_create((tui_config_t) { 0 });
+
+  if (!tui) return 0;
+
+  resizeterm(LAYOUT_H, LAYOUT_W);
+
+  for (int index = 0; index < 3; index++)
+  {
+    tui_window_parent_t* root = tui_window_parent_create(tui, (tui_window_parent_config_t)
+    {
+      .rect        = { .x = index * 50, .y = 0, .w = 50, .h = 0 },
+      .is_vertical = index % 2,
+      .align       = layout_rand() % 6,
+      .pos         = layout_rand() % 3,
+      .has_gap     = layout_rand() % 2
+    });
+
+    if (!root) break;
+
+    windows[window_count++] = (tui_window_t*) root;
+
+    layout_build(root, 0);
+  }
+
+  size_t diff_count = 0;
+
+  for (int frame = 0; frame < frames && window_count > 0; frame++)
+  {
+    layout_change();
+
+    tui_render(tui);
+
+    if (frame % LAYOUT_CHECK != 0) continue;
+
+    for (size_t index = 0; index < window_count; index++)
+    {
+      cached[index] = layout_place_get(windows[index]);
+    }
+
+    // Every window is layout dirty, so no child keeps its rect
+    tui_layout_dirty_set(tui);
+
+    tui_resize(tui);
+
+    (*check_count)++;
+
+    for (size_t index = 0; index < window_count; index++)
+    {
+      place_t place = layout_place_get(windows[index]);
+
+      if (layout_place_is_equal(cached[index], place)) continue;
+
+      if (diff_count == 0)
+      {
+        fprintf(stderr, "seed %zu frame %d window %zu: %d %d,%d %dx%d, from scratch %d %d,%d %dx%d\n",
+          run_seed, frame, index,
+          cached[index].is_visable, cached[index].rect.x, cached[index].rect.y, cached[index].rect.w, cached[index].rect.h,
+          place.is_visable, place.rect.x, place.rect.y, place.rect.w, place.rect.h);
+      }
+
+      diff_count++;
+    }
+  }
+
+  tui_delete(&tui);
+
+  return diff_count;
+}
+
+int main(int argc, char** argv)
+{
+  int seeds  = 200;
+  int frames = 300;
+
+  for (int index = 1; index < argc; index++)
+  {
+    if (strcmp(argv[index], "-s") == 0 && index + 1 < argc)
+    {
+      seeds = atoi(argv[++index]);
+
+      seeds = MAX(1, seeds);
+    }
+    else if (strcmp(argv[index], "-f") == 0 && index + 1 < argc)
+    {
+      frames = atoi(argv[++index]);
+
+      frames = MAX(1, frames);
+    }
+  }
+
+  // The report is written to stdout, and the tui to /dev/null
+  FILE* report = fdopen(dup(STDOUT_FILENO), "w");
+
+  if (!report || !freopen("/dev/null", "w", stdout))
+  {
+    fprintf(stderr, "layout: failed to open /dev/null\n");
+
+    return 1;
+  }
+
+  setenv("TERM", "xterm-256color", 0);
+
+  size_t check_count = 0;
+  size_t diff_count  = 0;
+  size_t diff_seeds  = 0;
+
+  for (int index = 1; index <= seeds; index++)
+  {
+    size_t count = layout_run(index, frames, &check_count);
+
+    diff_count += count;
+
+    if (count > 0) diff_seeds++;
+  }
+
+  fprintf(report, "tui.h layout: %d seeds, %d frames, %zu checks, %zu windows differ in %zu seeds\n",
+    seeds, frames, check_count, diff_count, diff_seeds);
+
+  fclose(report);
+
+  return (diff_count > 0) ? 1 : 0;
+}
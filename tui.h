@@ -3,14 +3,29 @@
  *
  * Written by Hampus Fridholm
  *
- * Last updated: 2026-01-15
+ * Last updated: 2026-10-14
  */
 
+// The implementation uses POSIX functions, like clock_gettime,
+// which a strict C standard, like -std=c99, leaves out.
+// It only has effect if no system header has been included before
+#if defined(TUI_IMPLEMENTATION) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #ifndef TUI_H
 #define TUI_H
 
+// UTF-8 text needs the wide character functions of ncursesw
+#ifdef TUI_UTF8
+#define NCURSES_WIDECHAR 1
+#include <locale.h>
+#include <wchar.h>
+#endif // TUI_UTF8
+
 #include <ncurses.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
@@ -113,6 +128,16 @@ const tui_rect_t TUI_PARENT_RECT = { 0 };
 #define TUI_PARENT_W 0
 #define TUI_PARENT_H 0
 
+// Max amount of unused ncurses WINDOWs kept for reuse
+#ifndef TUI_POOL_SIZE
+#define TUI_POOL_SIZE 64
+#endif // TUI_POOL_SIZE
+
+// Menu switches before an inactive menu releases its ncurses WINDOWs
+#ifndef TUI_MENU_KEEP
+#define TUI_MENU_KEEP 2
+#endif // TUI_MENU_KEEP
+
 /*
  * Foreground and background color struct
  */
@@ -179,6 +204,7 @@ typedef struct tui_window_parent_t tui_window_parent_t;
 typedef struct tui_window_text_t   tui_window_text_t;
 
 typedef struct tui_window_grid_t   tui_window_grid_t;
+typedef struct tui_window_log_t    tui_window_log_t;
 
 /*
  * Type of window
@@ -188,6 +214,7 @@ typedef enum tui_window_type_t
   TUI_WINDOW_PARENT,
   TUI_WINDOW_TEXT,
   TUI_WINDOW_GRID,
+  TUI_WINDOW_LOG,
 } tui_window_type_t;
 
 /*
@@ -204,20 +231,34 @@ typedef struct tui_window_t
   bool                 is_atomic;
   bool                 is_hidden;
   bool                 _is_visable;
+  bool                 _is_dirty; // Temp flag, content needs render
+  bool                 _is_layout_dirty; // Temp flag, size and rect needs calc
   bool                 is_interact;
   bool                 is_contain;
   bool                 w_grow;
   bool                 h_grow;
   tui_rect_t           rect;
   tui_rect_t           _rect;  // Temp calculated rect
+  tui_size_t           _calc_size; // Temp calculated size, based on content
+  tui_rect_t           _last_rect;   // Temp rect of last layout
+  bool                 _last_hidden; // Temp is_hidden of last layout
+  tui_size_t           _layout_size; // Temp _calc_size, when rect was aligned in parent
+  tui_rect_t           _layout_next; // Temp rect of next child, after rect was aligned
+  bool                 _is_aligned;  // Temp flag, rect was aligned in last layout of parent
+  tui_rect_t           _clip;        // Temp part of _rect inside the screen and the parent
   WINDOW*              window;
+  bool                 _is_shared;  // Temp flag, window shares the cells of the screen
   tui_color_t          color;
-  tui_color_t          _color; // Temp inherited color
+  tui_color_t          _color;      // Temp inherited color
+  short                _pair;       // Temp color pair of inherited color
+  size_t               _color_gen;  // Temp color generation of inherited color
+  tui_color_t          _last_color; // Temp color of last color check
   tui_window_event_t   event;
   tui_window_parent_t* parent;
   tui_menu_t*          menu;
   tui_t*               tui;
   void*                data;   // User attached data
+  int64_t              _render_us; // Temp time of last render, including children, with TUI_PROFILE
 } tui_window_t;
 
 /*
@@ -225,9 +266,10 @@ typedef struct tui_window_t
  */
 typedef struct tui_input_t
 {
-  char*              buffer;
+  char*              buffer; // Gap buffer, with the gap at _gap
   size_t             buffer_size;
   size_t             buffer_len;
+  size_t             _gap;   // Temp index of gap in buffer
   size_t             cursor;
   size_t             scroll;
   tui_window_text_t* window;
@@ -235,18 +277,90 @@ typedef struct tui_input_t
   tui_t*             tui;
 } tui_input_t;
 
+/*
+ * Text area data struct, that can be attached to window
+ *
+ * Multi-line input, where the text and the lengths of the lines
+ * are stored in gap buffers, with the gaps at the cursor
+ */
+typedef struct tui_textarea_t
+{
+  char*              buffer;       // Gap buffer, with the gap at _gap
+  size_t             buffer_size;
+  size_t             buffer_len;
+  size_t             _gap;         // Temp index of gap in buffer
+  size_t             cursor;
+  size_t*            lines;        // Gap buffer of line lengths, with the gap at line
+  size_t             line_size;
+  size_t             line_count;
+  size_t             line;         // Line of the cursor
+  size_t             column;       // Column of the cursor
+  size_t             _line_start;  // Temp index in buffer where line starts
+  size_t             scroll;       // First visable line
+  tui_window_text_t* window;
+  char*              string;       // Visable string
+  size_t             string_size;
+  tui_t*             tui;
+} tui_textarea_t;
+
+typedef struct tui_list_t tui_list_t;
+
+/*
+ * Callback that sets the content of a virtual row to the item at index
+ */
+typedef void (*tui_list_row_t)(tui_list_t* list, tui_window_text_t* row, size_t index);
+
 /*
  * List data struct, that can be attached to window
+ *
+ * A virtual list has no item windows, only rows that are recycled
  */
 typedef struct tui_list_t
 {
-  tui_window_t** items;
-  size_t         item_count;
-  size_t         item_index;
-  bool           is_vertical;
-  tui_t*         tui;
+  tui_window_t**       items;
+  size_t               item_count;
+  size_t               item_size;
+  size_t               item_index;
+  bool                 is_vertical;
+  tui_window_parent_t* parent;       // Parent of rows, if list is virtual
+  tui_list_row_t       row;          // Callback that sets content of row
+  tui_window_text_t**  rows;         // Pool of recycled rows
+  size_t               row_count;
+  size_t               row_size;
+  size_t               scroll;       // Index of item in first row
+  size_t*              indexes;      // Indexes of items in rows, if filtered
+  size_t               _last_scroll; // Temp scroll of last row update
+  size_t               _last_index;  // Temp item_index of last row update
+  bool                 _is_dirty;    // Temp flag, every row needs update
+  tui_t*               tui;
 } tui_list_t;
 
+/*
+ * Callback that gets the string of the item at index, to filter it
+ */
+typedef char* (*tui_list_string_t)(tui_list_t* list, size_t index);
+
+/*
+ * Filter data struct, that shows the items of list that contain the text of input
+ *
+ * The matches of every length of the query are stored after each other,
+ * so a longer query only searches the matches of the shorter query
+ */
+typedef struct tui_filter_t
+{
+  tui_list_t*       list;
+  tui_input_t*      input;
+  tui_list_string_t string;      // Callback that gets string of item
+  size_t            item_count;  // Amount of items, before filtering
+  size_t*           matches;     // Indexes of matching items, for every query length
+  size_t            match_size;
+  size_t*           _levels;     // Temp end in matches, for every query length
+  char*             _query;      // Temp query of matches
+  size_t            _query_len;
+  bool              _is_dirty;   // Temp flag, every item needs matching
+  tui_t*            tui;
+} tui_filter_t;
+
 /*
  * Position
  *
@@ -311,23 +425,111 @@ typedef struct tui_window_grid_t
   tui_window_t              head;
   tui_size_t                size;
   tui_size_t                _size;
+  tui_rect_t                _damage; // Temp rect of changed squares
   tui_window_grid_square_t* grid;
 } tui_window_grid_t;
 
+/*
+ * Text run struct
+ *
+ * ANSI code that applies from index in the extracted text
+ */
+typedef struct tui_text_run_t
+{
+  size_t index;
+  int    code;
+} tui_text_run_t;
+
+/*
+ * Text wrap struct
+ *
+ * Lines of text wrapped in width, stored for reuse
+ */
+typedef struct tui_text_wrap_t
+{
+  int    w;       // Width the text was wrapped in
+  int    h;       // Height of the wrapped text
+  int    min_w;   // Smallest width with the same height
+  int*   ws;      // Widths of the lines, wrapped in min_w
+  size_t ws_size;
+  bool   is_valid;
+} tui_text_wrap_t;
+
 /*
  * Text window struct
  */
 typedef struct tui_window_text_t
 {
-  tui_window_t head;
-  char*        string;
-  size_t       string_size;
-  char*        text;
-  bool         is_secret;
-  tui_pos_t    pos;
-  tui_align_t  align;
+  tui_window_t    head;
+  char*           string;
+  size_t          string_size;
+  char*           text;
+  size_t          text_len;
+  size_t          text_size;
+  tui_text_run_t* runs;
+  size_t          run_count;
+  size_t          run_size;
+  tui_text_wrap_t _wraps[2]; // Temp wraps for layout and render
+  size_t          _wrap_index;
+  uint8_t*        _widths;     // Temp cell width at every byte of text, with TUI_UTF8
+  wchar_t*        _glyphs;     // Temp decoded glyphs of text, with TUI_UTF8
+  size_t          _glyph_size;
+  bool            _is_utf8;    // Temp flag, text has multibyte glyphs
+  bool            is_secret;
+  tui_pos_t       pos;
+  tui_align_t     align;
 } tui_window_text_t;
 
+/*
+ * Log window line struct
+ */
+typedef struct tui_log_line_t
+{
+  size_t index;   // Index of line in buffer
+  size_t length;  // Length of line in bytes
+  int    _wrap_w; // Temp width the line was last wrapped in
+  int    _wrap_h; // Temp rows of line, wrapped in _wrap_w
+} tui_log_line_t;
+
+/*
+ * Log window struct
+ *
+ * Lines are stored in a ring buffer, and the oldest lines
+ * are dropped when the buffer or the lines are full
+ *
+ * scroll is the number of lines scrolled up from the newest line
+ */
+typedef struct tui_window_log_t
+{
+  tui_window_t    head;
+  char*           buffer;
+  size_t          buffer_size;
+  size_t          _buffer_end; // Temp index after the newest line
+  tui_log_line_t* lines;
+  size_t          line_max;
+  size_t          _line_start; // Temp index of the oldest line
+  size_t          line_count;
+  size_t          scroll;
+} tui_window_log_t;
+
+/*
+ * Layout struct, of what the rects of the children of a parent are calculated from
+ */
+typedef struct tui_layout_t
+{
+  tui_rect_t  rect;        // Rect of parent
+  tui_size_t  max_size;
+  tui_size_t  align_size;  // Combined size of aligned children, if it is used
+  int         align_count; // Amount of aligned children, if it is used
+  int         grow_count;
+  bool        is_vertical;
+  bool        has_padding;
+  bool        has_border;
+  bool        has_gap;
+  tui_pos_t   pos;
+  tui_align_t align;
+} tui_layout_t;
+
 /*
  * Parent window struct
  */
@@ -336,6 +538,7 @@ typedef struct tui_window_parent_t
   tui_window_t   head;
   tui_window_t** children;
   size_t         child_count;
+  size_t         child_size;
   bool           is_vertical;
   tui_border_t   border;
   bool           has_shadow;
@@ -343,6 +546,7 @@ typedef struct tui_window_parent_t
   bool           has_gap;
   tui_pos_t      pos;
   tui_align_t    align;
+  tui_layout_t   _layout; // Temp layout that children was calculated in
 } tui_window_parent_t;
 
 /*
@@ -355,8 +559,10 @@ typedef struct tui_menu_t
   tui_color_t      _color;
   tui_window_t**   windows;
   size_t           window_count;
+  size_t           window_size;
   tui_menu_event_t event;
   tui_t*           tui;
+  size_t           _exit_switch; // Temp menu switch when menu was exited
 } tui_menu_t;
 
 /*
@@ -369,22 +575,215 @@ typedef struct tui_cursor_t
   int  y;
 } tui_cursor_t;
 
+/*
+ * Cell of the screen, as it is written by an output
+ *
+ * The symbol is a Unicode code point, and 0 for the cell
+ * covered by the second half of a wide glyph. Combining marks are left out
+ */
+typedef struct tui_cell_t
+{
+  uint32_t    symbol;
+  tui_color_t color;
+} tui_cell_t;
+
+typedef struct tui_output_t tui_output_t;
+
+/*
+ * Output struct, that writes the rendered screen to the terminal
+ *
+ * Windows are still rendered with ncurses onto the screen, so ncurses
+ * and terminfo are still needed. The output only replaces how the
+ * screen is written: after every render, only the runs of cells that
+ * have changed are put, each run with a single color that is set
+ * before it. Then the cursor is set and the frame is flushed
+ */
+typedef struct tui_output_t
+{
+  void  (*cells_put)   (tui_output_t* output, int x, int y, tui_cell_t* cells, size_t count);
+  void  (*color_change)(tui_output_t* output, tui_color_t color);
+  void  (*cursor_set)  (tui_output_t* output, tui_cursor_t cursor);
+  void  (*flush)       (tui_output_t* output, bool is_sync);
+  void* data; // User attached data
+} tui_output_t;
+
+/*
+ * VT output struct, that writes VT escape sequences to fd
+ *
+ * The sequences of a frame are collected in buffer and written at once.
+ * The cursor and color of the terminal are remembered,
+ * so they are only written when they change
+ */
+typedef struct tui_vt_output_t
+{
+  tui_output_t head;
+  int          fd;
+  bool         is_truecolor;
+  uint32_t     palette[16];  // RGB (0xRRGGBB) of tui colors, except TUI_COLOR_NONE
+  char*        buffer;
+  size_t       buffer_size;
+  size_t       buffer_len;
+  int          _x;           // Temp x of the terminal cursor, or -1 if unknown
+  int          _y;           // Temp y of the terminal cursor
+  tui_color_t  _color;       // Temp color of the terminal
+  bool         _has_color;   // Temp flag, _color is known
+  bool         _is_line;     // Temp flag, DEC line drawing is on
+  bool         _is_shown;    // Temp flag, the terminal cursor is shown
+} tui_vt_output_t;
+
+/*
+ * Timer struct
+ *
+ * The event is triggered every ms milliseconds if is_repeat,
+ * otherwise only once
+ */
+typedef struct tui_timer_t
+{
+  int     id;
+  int     ms;
+  bool    is_repeat;
+  int64_t _time; // Temp time of next trigger, in milliseconds
+  void  (*event) (tui_t* tui, void* data);
+  void*   data;
+} tui_timer_t;
+
+/*
+ * File descriptor struct
+ *
+ * The event is triggered when poll reports any of events on fd
+ */
+typedef struct tui_fd_t
+{
+  int   fd;
+  short events;
+  void (*event) (tui_t* tui, int fd, short revents, void* data);
+  void* data;
+} tui_fd_t;
+
+/*
+ * Type of command
+ */
+typedef enum tui_command_type_t
+{
+  TUI_COMMAND_TEXT,
+  TUI_COMMAND_GRID,
+  TUI_COMMAND_HIDE,
+} tui_command_type_t;
+
+/*
+ * Command struct
+ *
+ * Change to window, queued from another thread
+ */
+typedef struct tui_command_t
+{
+  tui_command_type_t    type;
+  tui_window_t*         window;
+  tui_rect_t            rect;
+  bool                  is_hidden;
+  void*                 data; // Copy of string or squares
+  struct tui_command_t* next;
+} tui_command_t;
+
+/*
+ * Arena struct
+ *
+ * Block of memory that windows and menus are allocated from,
+ * and that is freed all at once
+ */
+typedef struct tui_arena_t
+{
+  struct tui_arena_t* next; // Previous block
+  size_t              size;
+  size_t              used;
+} tui_arena_t;
+
+/*
+ * Window index struct
+ *
+ * Hash table of windows by name,
+ * and by the parent window, menu or tui they are in
+ */
+typedef struct tui_index_t
+{
+  tui_window_t** windows;
+  size_t         size;
+  size_t         count; // Used slots, including removed windows
+} tui_index_t;
+
+/*
+ * Stats struct, with timings and counts of the last rendered frame
+ *
+ * Counts include everything since the frame before,
+ * like allocations made in events
+ *
+ * The stats are only recorded with TUI_PROFILE, otherwise they stay zero
+ */
+typedef struct tui_stats_t
+{
+  int64_t       update_time;  // Time of update, in microseconds
+  int64_t       size_time;    // Time of size calculation, in microseconds
+  int64_t       rect_time;    // Time of rect calculation, in microseconds
+  int64_t       render_time;  // Time of render, in microseconds
+  int64_t       present_time; // Time of writing to terminal, in microseconds
+  size_t        draw_count;   // Amount of ncurses draw calls
+  size_t        copy_count;   // Amount of ncurses WINDOW* copies
+  size_t        pair_count;   // Amount of color pair lookups
+  size_t        alloc_count;  // Amount of allocations
+  size_t        window_count; // Amount of rendered windows
+  tui_window_t* slow_window;  // Slowest rendered window, that is not a parent
+  int64_t       slow_time;    // Render time of slowest window, in microseconds
+} tui_stats_t;
+
 /*
  * Tui struct
  */
 typedef struct tui_t
 {
-  tui_size_t     size;
-  tui_menu_t**   menus;
-  size_t         menu_count;
-  tui_window_t** windows;
-  size_t         window_count;
-  tui_menu_t*    menu;
-  tui_window_t*  window;
-  tui_color_t    color;
-  tui_cursor_t   cursor;
-  tui_event_t    event;
-  bool           is_running;
+  tui_size_t              size;
+  tui_menu_t**            menus;
+  size_t                  menu_count;
+  size_t                  menu_size;
+  tui_window_t**          windows;
+  size_t                  window_count;
+  size_t                  window_size;
+  tui_menu_t*             menu;
+  tui_window_t*           window;
+  tui_color_t             color;
+  tui_color_t             _last_color;  // Temp color of last color check
+  size_t                  _color_gen;   // Temp color generation, incremented on change
+  tui_cursor_t            cursor;
+  tui_event_t             event;
+  tui_timer_t*            timers;
+  size_t                  timer_count;
+  int                     _timer_id; // Temp id of the last added timer
+  tui_fd_t*               fds;
+  size_t                  fd_count;
+  int                     fps;
+  int64_t                 _render_time; // Temp time of last render, in milliseconds
+  struct tui_queue_t*     _queue;       // Temp commands queued from other threads
+  int                     _wake_fds[2]; // Temp pipe that wakes the main loop
+  tui_index_t             _index;       // Temp index of windows by name
+  size_t                  arena_size;
+  tui_arena_t*            _arena;       // Temp newest arena block
+  bool                    is_composite;
+  bool                    is_sync;
+  bool                    is_running;
+  bool                    _is_dirty;    // Temp flag, screen needs render
+  bool                    _is_shown;    // Temp flag, rendered screen is shown
+  bool                    _is_damaged;  // Temp flag, whole screen is rendered again
+  size_t                  _layout_gen;  // Temp layout generation, incremented on change
+  size_t                  _layout_calc; // Temp layout generation of last calculation
+  WINDOW**                _pool;        // Temp unused ncurses WINDOWs, kept for reuse
+  size_t                  _pool_count;
+  size_t                  _pool_size;
+  size_t                  _menu_switch; // Temp amount of menu switches
+  tui_output_t*           output;
+  tui_cell_t*             _front;       // Temp cells shown by the output
+  size_t                  _front_size;
+  bool                    _is_front_valid; // Temp flag, _front is what the terminal shows
+  tui_stats_t             stats;
+  bool                    is_stats_shown;
 } tui_t;
 
 #endif // TUI_H
@@ -392,52 +791,252 @@ typedef struct tui_t
 #ifdef TUI_IMPLEMENTATION
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+
+// The scanners of text use the widest vector instructions that are enabled,
+// unless TUI_NO_SIMD is defined
+#ifndef TUI_NO_SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TUI_SIMD_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TUI_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TUI_SIMD_NEON
+#endif
+#endif // TUI_NO_SIMD
+
+// Flag of the cell width at the first byte of a glyph
+#define TUI_GLYPH_START 0x80
+
+#ifdef TUI_UTF8
 
-#define CACHE_SIZE 128
+// wcwidth is only declared by wchar.h with _XOPEN_SOURCE
+extern int wcwidth(wchar_t glyph);
 
-static tui_color_t COLOR_CACHE[CACHE_SIZE];
-static short       pair_count = 1;
+#endif // TUI_UTF8
 
 /*
- * Get ncurses color pair from tui color
+ * Check if two rects are equal
  */
-static inline short tui_color_pair_get(tui_color_t color)
+static inline bool tui_rect_is_equal(tui_rect_t a, tui_rect_t b)
+{
+  return a.w == b.w && a.h == b.h &&
+         a.x == b.x && a.y == b.y &&
+         a.is_none == b.is_none;
+}
+
+/*
+ * Get the part of rect a that is inside rect b
+ *
+ * If the rects don't overlap, NONE rect is returned
+ */
+static inline tui_rect_t tui_rect_intersect_get(tui_rect_t a, tui_rect_t b)
+{
+  int x1 = MAX(a.x, b.x);
+  int y1 = MAX(a.y, b.y);
+  int x2 = MIN(a.x + a.w, b.x + b.w);
+  int y2 = MIN(a.y + a.h, b.y + b.h);
+
+  if (a.is_none || b.is_none || x1 >= x2 || y1 >= y2)
+  {
+    return TUI_RECT_NONE;
+  }
+
+  return (tui_rect_t)
+  {
+    .x = x1,
+    .y = y1,
+    .w = x2 - x1,
+    .h = y2 - y1
+  };
+}
+
+/*
+ * Get the smallest rect that contains both rect a and rect b
+ *
+ * An empty rect is left out, so the union of it and rect b is rect b
+ */
+static inline tui_rect_t tui_rect_union_get(tui_rect_t a, tui_rect_t b)
 {
-  // Pair (0) is already reserved
-  for (short pair = 1; pair < pair_count; pair++)
+  if (a.is_none || a.w <= 0 || a.h <= 0) return b;
+
+  if (b.is_none || b.w <= 0 || b.h <= 0) return a;
+
+  int x1 = MIN(a.x, b.x);
+  int y1 = MIN(a.y, b.y);
+  int x2 = MAX(a.x + a.w, b.x + b.w);
+  int y2 = MAX(a.y + a.h, b.y + b.h);
+
+  return (tui_rect_t)
   {
-    tui_color_t curr_color = COLOR_CACHE[pair];
+    .x = x1,
+    .y = y1,
+    .w = x2 - x1,
+    .h = y2 - y1
+  };
+}
+
+// Amount of tui colors, including TUI_COLOR_NONE
+#define TUI_COLOR_COUNT 17
+
+// Every fg-bg combination can have a pair, and pair (0) is reserved
+#define CACHE_SIZE (TUI_COLOR_COUNT * TUI_COLOR_COUNT + 1)
+
+// COLOR_PAIR() only has 8 bits, higher pairs would turn into attributes
+#define TUI_PAIR_LIMIT 256
+
+// Most times the screen is rendered again in a frame, because pairs were reused
+#define TUI_RENDER_PASSES 4
+
+static short       PAIR_CACHE[TUI_COLOR_COUNT][TUI_COLOR_COUNT]; // Pair of color
+static tui_color_t COLOR_CACHE[CACHE_SIZE]; // Color of pair
+static size_t      PAIR_USES[CACHE_SIZE];   // Last use of pair
+static short       pair_count   = 1;
+static size_t      pair_use     = 0;
+static size_t      pair_frame   = 0;     // Last use before current frame
+static bool        pair_evicted = false; // A pair has been reused
+
+#ifdef TUI_PROFILE
+
+// Stats of the frame that is being rendered
+static tui_stats_t frame_stats = { 0 };
+
+/*
+ * Get monotonic time in microseconds
+ */
+static inline int64_t tui_time_us_get(void)
+{
+  struct timespec time;
+
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return (int64_t) time.tv_sec * 1000000 + time.tv_nsec / 1000;
+}
+
+#define TUI_STATS_ADD(field, amount) (frame_stats.field += (amount))
+
+// Count ncurses draw call
+#define TUI_DRAW(call) (frame_stats.draw_count++, (call))
+
+#define TUI_STATS_TIME(field, statement)                \
+  do                                                    \
+  {                                                     \
+    int64_t start = tui_time_us_get();                  \
+                                                        \
+    statement;                                          \
+                                                        \
+    frame_stats.field += tui_time_us_get() - start;     \
+  }                                                     \
+  while (false)
+
+#else // TUI_PROFILE
+
+#define TUI_STATS_ADD(field, amount)
+
+#define TUI_DRAW(call) (call)
+
+#define TUI_STATS_TIME(field, statement) statement
+
+#endif // TUI_PROFILE
+
+/*
+ * Evict the least recently used color pair, so it can be reused
+ *
+ * Pairs used in the current frame can't be evicted,
+ * because their cells would change color
+ *
+ * RETURN (short pair)
+ * - 0 | No pair could be evicted
+ */
+static inline short tui_color_pair_evict(void)
+{
+  short lru_pair = 1;
 
-    if (curr_color.bg == color.bg &&
-        curr_color.fg == color.fg)
+  for (short pair = 2; pair < pair_count; pair++)
+  {
+    if (PAIR_USES[pair] < PAIR_USES[lru_pair])
     {
-      return pair;
+      lru_pair = pair;
     }
   }
 
-  // Only (COLORS) amount of pairs can exist
-  if (pair_count >= COLORS)
+  if (lru_pair >= pair_count || PAIR_USES[lru_pair] > pair_frame)
+  {
+    return 0;
+  }
+
+  tui_color_t color = COLOR_CACHE[lru_pair];
+
+  PAIR_CACHE[color.fg][color.bg] = 0;
+
+  pair_evicted = true;
+
+  return lru_pair;
+}
+
+/*
+ * Get ncurses color pair from tui color
+ *
+ * The pair is looked up directly by fg and bg,
+ * and a new pair is initialized the first time a color is used
+ */
+static inline short tui_color_pair_get(tui_color_t color)
+{
+  if (color.fg < 0 || color.fg >= TUI_COLOR_COUNT ||
+      color.bg < 0 || color.bg >= TUI_COLOR_COUNT)
   {
     return 0;
   }
 
-  short new_pair = pair_count++;
+  TUI_STATS_ADD(pair_count, 1);
+
+  short pair = PAIR_CACHE[color.fg][color.bg];
+
+  if (pair)
+  {
+    PAIR_USES[pair] = ++pair_use;
+
+    return pair;
+  }
+
+  // Only (COLOR_PAIRS) amount of pairs can exist, and only 255 fit in COLOR_PAIR(),
+  // after that the least recently used pair is reused
+  if (pair_count < MIN(COLOR_PAIRS, TUI_PAIR_LIMIT))
+  {
+    pair = pair_count++;
+  }
+  else if ((pair = tui_color_pair_evict()) == 0)
+  {
+    return 0;
+  }
 
   // ncurses colors differ from tui colors by 1
   short fg = (color.fg - 1);
   short bg = (color.bg - 1);
 
-  if (init_pair(new_pair, fg, bg) == ERR)
+  if (init_pair(pair, fg, bg) == ERR)
   {
     return 0;
   }
 
-  COLOR_CACHE[new_pair] = color;
+  PAIR_CACHE[color.fg][color.bg] = pair;
 
-  return new_pair;
+  COLOR_CACHE[pair] = color;
+
+  PAIR_USES[pair] = ++pair_use;
+
+  return pair;
 }
 
 /*
@@ -460,6 +1059,14 @@ static inline tui_color_t tui_color_inherit(tui_color_t parent, tui_color_t chil
   return child;
 }
 
+/*
+ * Check if two colors are equal
+ */
+static inline bool tui_color_is_equal(tui_color_t a, tui_color_t b)
+{
+  return a.fg == b.fg && a.bg == b.bg;
+}
+
 /*
  * Inherit true color from window's ancestors, in case of transparency
  */
@@ -494,6 +1101,26 @@ static inline tui_color_t tui_window_color_inherit(tui_window_t* window, tui_col
   return color;
 }
 
+/*
+ * Get inherited color of window
+ *
+ * The color is only inherited again after a color has changed,
+ * the ancestors of the window must be up to date
+ */
+static inline tui_color_t tui_window_color_get(tui_window_t* window)
+{
+  tui_t* tui = window->tui;
+
+  if (!tui || window->_color_gen != tui->_color_gen)
+  {
+    window->_color = tui_window_color_inherit(window, window->color);
+
+    window->_color_gen = tui ? tui->_color_gen : 0;
+  }
+
+  return window->_color;
+}
+
 /*
  * Turn on color of window
  */
@@ -559,10 +1186,10 @@ void tui_border_draw(tui_window_parent_t* window)
   // Draw left-upper part of border
   tui_ncurses_window_color_on(head->window, color1);
 
-  mvwaddch(head->window, 0,                            0, ACS_ULCORNER);
-  mvwaddch(head->window, head->_rect.h - 1 - shadow_h, 0, ACS_LLCORNER);
-  mvwhline(head->window, 0,                            1, ACS_HLINE, head->_rect.w - 2 - shadow_w);
-  mvwvline(head->window, 1,                            0, ACS_VLINE, head->_rect.h - 2 - shadow_h);
+  TUI_DRAW(mvwaddch(head->window, 0,                            0, ACS_ULCORNER));
+  TUI_DRAW(mvwaddch(head->window, head->_rect.h - 1 - shadow_h, 0, ACS_LLCORNER));
+  TUI_DRAW(mvwhline(head->window, 0,                            1, ACS_HLINE, head->_rect.w - 2 - shadow_w));
+  TUI_DRAW(mvwvline(head->window, 1,                            0, ACS_VLINE, head->_rect.h - 2 - shadow_h));
 
   tui_ncurses_window_color_off(head->window, color1);
 
@@ -570,10 +1197,10 @@ void tui_border_draw(tui_window_parent_t* window)
   // Draw right-bottom part of border
   tui_ncurses_window_color_on(head->window, color2);
 
-  mvwaddch(head->window, 0,                            head->_rect.w - 1 - shadow_w, ACS_URCORNER);
-  mvwaddch(head->window, head->_rect.h - 1 - shadow_h, head->_rect.w - 1 - shadow_w, ACS_LRCORNER);
-  mvwvline(head->window, 1,                            head->_rect.w - 1 - shadow_w, ACS_VLINE, head->_rect.h - 2 - shadow_h);
-  mvwhline(head->window, head->_rect.h - 1 - shadow_h, 1,                            ACS_HLINE, head->_rect.w - 2 - shadow_w);
+  TUI_DRAW(mvwaddch(head->window, 0,                            head->_rect.w - 1 - shadow_w, ACS_URCORNER));
+  TUI_DRAW(mvwaddch(head->window, head->_rect.h - 1 - shadow_h, head->_rect.w - 1 - shadow_w, ACS_LRCORNER));
+  TUI_DRAW(mvwvline(head->window, 1,                            head->_rect.w - 1 - shadow_w, ACS_VLINE, head->_rect.h - 2 - shadow_h));
+  TUI_DRAW(mvwhline(head->window, head->_rect.h - 1 - shadow_h, 1,                            ACS_HLINE, head->_rect.w - 2 - shadow_w));
 
   tui_ncurses_window_color_off(head->window, color2);
 }
@@ -593,16 +1220,10 @@ void tui_shadow_draw(tui_window_parent_t* window)
 
   tui_ncurses_window_color_on(head->window, color);
 
-  for (int y = 1; y < head->_rect.h; y++)
-  {
-    mvwaddch(head->window, y, head->_rect.w - 2, ' ');
-    waddch(head->window, ' ');
-  }
+  TUI_DRAW(mvwvline(head->window, 1, head->_rect.w - 2, ' ', head->_rect.h - 1));
+  TUI_DRAW(mvwvline(head->window, 1, head->_rect.w - 1, ' ', head->_rect.h - 1));
 
-  for (int x = 2; x < head->_rect.w; x++)
-  {
-    mvwaddch(head->window, head->_rect.h - 1, x, ' ');
-  }
+  TUI_DRAW(mvwhline(head->window, head->_rect.h - 1, 2, ' ', head->_rect.w - 2));
 
   tui_ncurses_window_color_off(head->window, color);
 }
@@ -612,6 +1233,11 @@ void tui_shadow_draw(tui_window_parent_t* window)
  */
 int tui_ncurses_init(void)
 {
+#ifdef TUI_UTF8
+  // The locale decides how ncursesw writes wide characters
+  setlocale(LC_ALL, "");
+#endif // TUI_UTF8
+
   initscr();
   noecho();
   raw();
@@ -668,36 +1294,47 @@ static inline WINDOW* tui_ncurses_window_create(tui_rect_t rect)
 }
 
 /*
- * Resize ncurses WINDOW*
+ * Create ncurses WINDOW* sharing the cells of the screen
+ *
+ * Everything drawn in the window is drawn directly onto the screen,
+ * clipped to the rect of the window
  */
-static inline WINDOW* tui_ncurses_window_resize(WINDOW* window, tui_rect_t rect)
+static inline WINDOW* tui_ncurses_subwindow_create(tui_rect_t rect)
 {
-  // Don't resize window to no size
+  // Can't create window with no size
   if (rect.w == 0 || rect.h == 0)
   {
-    return window;
+    return NULL;
   }
 
-  wresize(window, rect.h, rect.w);
+  WINDOW* window = subwin(stdscr, rect.h, rect.w, rect.y, rect.x);
 
-  mvwin(window, rect.y, rect.x);
+  if (!window)
+  {
+    return NULL;
+  }
+
+  keypad(window, TRUE);
 
   return window;
 }
 
 /*
- * Update ncurses WINDOW*, either creating it or resizing it
+ * Resize ncurses WINDOW*
  */
-static inline WINDOW* tui_ncurses_window_update(WINDOW* window, tui_rect_t rect)
+static inline WINDOW* tui_ncurses_window_resize(WINDOW* window, tui_rect_t rect)
 {
-  if (window)
-  {
-    return tui_ncurses_window_resize(window, rect);
-  }
-  else
+  // Don't resize window to no size
+  if (rect.w == 0 || rect.h == 0)
   {
-    return tui_ncurses_window_create(rect);
+    return window;
   }
+
+  wresize(window, rect.h, rect.w);
+
+  mvwin(window, rect.y, rect.x);
+
+  return window;
 }
 
 /*
@@ -717,29 +1354,133 @@ static inline void tui_ncurses_window_free(WINDOW** window)
 }
 
 /*
- * Fill ncurses WINDOW* with spaces
+ * Get ncurses WINDOW* for rect, from the pool of unused WINDOWs
+ *
+ * An unused WINDOW* of the same size is preferred, otherwise the last
+ * unused WINDOW* is resized. If the pool is empty, a WINDOW* is created
  */
-static inline void tui_ncurses_window_fill(WINDOW* window)
+static inline WINDOW* tui_ncurses_window_get(tui_t* tui, tui_rect_t rect)
 {
-  int w = getmaxx(window);
-  int h = getmaxy(window);
+  if (tui->_pool_count == 0 || rect.w == 0 || rect.h == 0)
+  {
+    return tui_ncurses_window_create(rect);
+  }
 
-  for (int y = 0; y < h; y++)
+  size_t found = tui->_pool_count - 1;
+
+  for (size_t index = 0; index < tui->_pool_count; index++)
   {
-    for (int x = 0; x < w; x++)
+    WINDOW* window = tui->_pool[index];
+
+    if (getmaxx(window) == rect.w && getmaxy(window) == rect.h)
     {
-      mvwaddch(window, y, x, ' ');
+      found = index;
+
+      break;
     }
   }
-}
 
-/*
- * Configuration struct for creating tui
- */
+  WINDOW* window = tui->_pool[found];
+
+  tui->_pool[found] = tui->_pool[--tui->_pool_count];
+
+  // Attributes from the last render are turned off, like in a new WINDOW*
+  wattrset(window, A_NORMAL);
+
+  wresize(window, rect.h, rect.w);
+
+  // A WINDOW* can be created partly outside the screen, but not moved there
+  if (mvwin(window, rect.y, rect.x) == ERR)
+  {
+    delwin(window);
+
+    return tui_ncurses_window_create(rect);
+  }
+
+  return window;
+}
+
+/*
+ * Release ncurses WINDOW* to the pool of unused WINDOWs
+ *
+ * If the pool is full, the WINDOW* is deleted. In composite mode,
+ * the WINDOW* shares the cells of the screen and is always deleted
+ */
+static inline void tui_ncurses_window_release(tui_t* tui, WINDOW** window)
+{
+  if (!(*window)) return;
+
+  if (tui->is_composite || tui->_pool_count >= tui->_pool_size)
+  {
+    tui_ncurses_window_free(window);
+
+    return;
+  }
+
+  tui->_pool[tui->_pool_count++] = *window;
+
+  *window = NULL;
+}
+
+/*
+ * Turn on inherited color of window
+ *
+ * The color pair is cached, and only looked up again
+ * if the pair has been reused for another color
+ */
+static inline void tui_window_color_on(tui_window_t* window)
+{
+  short pair = window->_pair;
+
+  if (pair && tui_color_is_equal(COLOR_CACHE[pair], window->_color))
+  {
+    PAIR_USES[pair] = ++pair_use;
+  }
+  else
+  {
+    pair = window->_pair = tui_color_pair_get(window->_color);
+  }
+
+  wattron(window->window, COLOR_PAIR(pair));
+}
+
+/*
+ * Fill rect of ncurses WINDOW* with spaces
+ */
+static inline void tui_ncurses_window_fill(WINDOW* window, tui_rect_t rect)
+{
+  for (int y = rect.y; y < rect.y + rect.h; y++)
+  {
+    TUI_DRAW(mvwhline(window, y, rect.x, ' ', rect.w));
+  }
+}
+
+/*
+ * Queue struct
+ *
+ * Commands are pushed onto the stack from any thread,
+ * and the main thread moves them to the list, in the order they were queued
+ *
+ * The queue is only declared here, so including tui.h doesn't need C11 atomics
+ */
+typedef struct tui_queue_t
+{
+  _Atomic(tui_command_t*) stack;
+  tui_command_t*          list; // Temp commands taken from stack, oldest first
+} tui_queue_t;
+
+/*
+ * Configuration struct for creating tui
+ */
 typedef struct tui_config_t
 {
-  tui_color_t color;
-  tui_event_t event;
+  tui_color_t    color;
+  tui_event_t    event;
+  int            fps;          // Max frames per second, or 0 for no limit
+  size_t         arena_size;   // Size of arena blocks, or 0 for no arena
+  bool           is_composite; // Draw all windows directly onto the screen
+  bool           is_sync;      // Show every frame at once, with synchronized output
+  tui_output_t*  output;       // Writes the rendered screen to the terminal, or NULL for ncurses
 } tui_config_t;
 
 /*
@@ -765,12 +1506,49 @@ tui_t* tui_create(tui_config_t config)
 
   *tui = (tui_t)
   {
-    .size.w = getmaxx(stdscr),
-    .size.h = getmaxy(stdscr),
-    .event  = config.event,
-    .color  = config.color
+    .size.w     = getmaxx(stdscr),
+    .size.h     = getmaxy(stdscr),
+    .event      = config.event,
+    .color      = config.color,
+    .fps          = MAX(0, config.fps),
+    .arena_size   = config.arena_size,
+    .is_composite = config.is_composite,
+    .is_sync      = config.is_sync,
+    .output       = config.output,
+    ._last_color  = config.color,
+    ._color_gen   = 1,
+    ._wake_fds    = { -1, -1 },
+    ._is_dirty    = true,
+    ._is_damaged  = true
   };
 
+  // The pipe is used by other threads to wake the main loop
+  if (pipe(tui->_wake_fds) == 0)
+  {
+    fcntl(tui->_wake_fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(tui->_wake_fds[1], F_SETFL, O_NONBLOCK);
+  }
+  else
+  {
+    tui->_wake_fds[0] = -1;
+    tui->_wake_fds[1] = -1;
+  }
+
+  // If the queue can't be allocated, commands can't be queued
+  tui->_queue = malloc(sizeof(tui_queue_t));
+
+  if (tui->_queue)
+  {
+    atomic_init(&tui->_queue->stack, NULL);
+
+    tui->_queue->list = NULL;
+  }
+
+  // If the pool can't be allocated, no WINDOW* is kept for reuse
+  tui->_pool = malloc(sizeof(WINDOW*) * TUI_POOL_SIZE);
+
+  tui->_pool_size = tui->_pool ? TUI_POOL_SIZE : 0;
+
   if (tui->event.init)
   {
     tui->event.init(tui);
@@ -779,2751 +1557,7952 @@ tui_t* tui_create(tui_config_t config)
   return tui;
 }
 
-static inline void tui_windows_free(tui_window_t*** windows, size_t* count);
+/*
+ * Union of the types with the strictest alignment,
+ * memory aligned to its size is aligned for any type
+ *
+ * max_align_t would do the same, but it is not in C99
+ */
+typedef union tui_arena_align_t
+{
+  long long   integer;
+  long double number;
+  void*       pointer;
+  void        (*function)(void);
+} tui_arena_align_t;
 
 /*
- * Free parent window struct
+ * Allocate memory for window or menu
+ *
+ * If the tui has an arena, the memory is allocated from the arena
+ * and a new block is added when the newest block is full
  */
-static inline void tui_window_parent_free(tui_window_parent_t** window)
+static inline void* tui_arena_alloc(tui_t* tui, size_t size)
 {
-  tui_windows_free(&(*window)->children, &(*window)->child_count);
+  if (tui->arena_size == 0)
+  {
+    TUI_STATS_ADD(alloc_count, 1);
 
-  tui_ncurses_window_free(&(*window)->head.window);
+    return malloc(size);
+  }
 
-  free(*window);
+  // Keep the memory aligned for any type
+  size_t align = sizeof(tui_arena_align_t);
 
-  *window = NULL;
-}
+  size = (size + align - 1) / align * align;
 
-/*
- * Free text window struct
- */
-static inline void tui_window_text_free(tui_window_text_t** window)
-{
-  tui_ncurses_window_free(&(*window)->head.window);
+  size_t header = (sizeof(tui_arena_t) + align - 1) / align * align;
 
-  free((*window)->string);
+  tui_arena_t* arena = tui->_arena;
 
-  free((*window)->text);
+  if (!arena || arena->used + size > arena->size)
+  {
+    size_t arena_size = MAX(tui->arena_size, size);
 
-  free(*window);
+    TUI_STATS_ADD(alloc_count, 1);
 
-  *window = NULL;
-}
+    arena = malloc(header + arena_size);
 
-/*
- * Free grid window struct
- */
-static inline void tui_window_grid_free(tui_window_grid_t** window)
-{
-  tui_ncurses_window_free(&(*window)->head.window);
+    if (!arena)
+    {
+      return NULL;
+    }
 
-  free((*window)->grid);
+    *arena = (tui_arena_t)
+    {
+      .next = tui->_arena,
+      .size = arena_size
+    };
 
-  free(*window);
+    tui->_arena = arena;
+  }
 
-  *window = NULL;
+  void* pointer = (char*) arena + header + arena->used;
+
+  arena->used += size;
+
+  return pointer;
 }
 
 /*
- * Free window struct
+ * Free memory of window or menu
+ *
+ * Memory from the arena is only freed when the arena is deleted
  */
-static inline void tui_window_free(tui_window_t** window)
+static inline void tui_arena_free(tui_t* tui, void* pointer)
 {
-  if (!window || !(*window)) return;
-
-  if ((*window)->event.free)
+  if (tui->arena_size == 0)
   {
-    (*window)->event.free(*window);
+    free(pointer);
   }
+}
 
-  switch ((*window)->type)
-  {
-    case TUI_WINDOW_PARENT:
-      tui_window_parent_free((tui_window_parent_t**) window);
-      break;
+/*
+ * Delete every block of the arena
+ */
+static inline void tui_arena_delete(tui_t* tui)
+{
+  tui_arena_t* arena = tui->_arena;
 
-    case TUI_WINDOW_TEXT:
-      tui_window_text_free((tui_window_text_t**) window);
-      break;
+  while (arena)
+  {
+    tui_arena_t* next = arena->next;
 
-    case TUI_WINDOW_GRID:
-      tui_window_grid_free((tui_window_grid_t**) window);
-      break;
+    free(arena);
 
-    default:
-      break;
+    arena = next;
   }
+
+  tui->_arena = NULL;
 }
 
 /*
- * Free windows
+ * Marker of removed window in index
  */
-static inline void tui_windows_free(tui_window_t*** windows, size_t* count)
-{
-  if (!windows || !(*windows)) return;
+static tui_window_t TUI_INDEX_REMOVED;
 
-  for (size_t index = 0; index < *count; index++)
-  {
-    tui_window_free(&(*windows)[index]);
-  }
+/*
+ * Get the parent window, menu or tui that window is in
+ */
+static inline void* tui_window_scope_get(tui_window_t* window)
+{
+  if (window->parent) return window->parent;
 
-  free(*windows);
+  if (window->menu) return window->menu;
 
-  *windows = NULL;
-  *count = 0;
+  return window->tui;
 }
 
 /*
- * Free menu struct
+ * Get hash of name in scope
  */
-static inline void tui_menu_free(tui_menu_t** menu)
+static inline size_t tui_index_hash(void* scope, char* name, size_t length)
 {
-  if (!menu || !(*menu)) return;
+  uint64_t hash = 14695981039346656037ULL ^ (uint64_t) (uintptr_t) scope;
 
-  tui_windows_free(&(*menu)->windows, &(*menu)->window_count);
+  for (size_t index = 0; index < length; index++)
+  {
+    hash ^= (unsigned char) name[index];
 
-  free(*menu);
+    hash *= 1099511628211ULL;
+  }
 
-  *menu = NULL;
+  return hash;
 }
 
 /*
- * Delete (free) tui struct and quit ncurses
+ * Check if window has name in scope
  */
-void tui_delete(tui_t** tui)
+static inline bool tui_window_is_named(tui_window_t* window, void* scope, char* name, size_t length)
 {
-  if (!tui || !(*tui)) return;
-
-  for (size_t index = 0; index < (*tui)->menu_count; index++)
-  {
-    tui_menu_free(&(*tui)->menus[index]);
-  }
+  return (window->name &&
+          tui_window_scope_get(window) == scope &&
+          strlen(window->name) == length &&
+          strncmp(window->name, name, length) == 0);
+}
 
-  free((*tui)->menus);
+/*
+ * Get window with name in scope from index
+ */
+static inline tui_window_t* tui_index_window_get(tui_index_t* index, void* scope, char* name, size_t length)
+{
+  if (index->size == 0) return NULL;
 
-  tui_windows_free(&(*tui)->windows, &(*tui)->window_count);
+  size_t mask = index->size - 1;
 
-  free(*tui);
+  for (size_t slot = tui_index_hash(scope, name, length) & mask;; slot = (slot + 1) & mask)
+  {
+    tui_window_t* window = index->windows[slot];
 
-  *tui = NULL;
+    if (!window) return NULL;
 
-  tui_ncurses_quit();
+    if (window != &TUI_INDEX_REMOVED &&
+        tui_window_is_named(window, scope, name, length))
+    {
+      return window;
+    }
+  }
 }
 
+static inline int tui_index_window_add(tui_index_t* index, tui_window_t* window);
+
 /*
- * Trigger tui event
- *
- * Start by calling active window event handler
- *
- * If the event was handled, stop trigger events
- *
- * Otherwise, call parent event handler, and so on...
+ * Resize index, leaving out removed windows
  */
-bool tui_event(tui_t* tui, int key)
+static inline int tui_index_resize(tui_index_t* index, size_t size)
 {
-  tui_window_t* window = tui->window;
+  TUI_STATS_ADD(alloc_count, 1);
 
-  while (window)
-  {
-    if (window->event.key && window->event.key(window, key))
-    {
-      return true;
-    }
+  tui_window_t** windows = calloc(size, sizeof(tui_window_t*));
 
-    window = (tui_window_t*) window->parent;
+  if (!windows)
+  {
+    return 1;
   }
 
-  tui_menu_t* menu = tui->menu;
+  tui_index_t old_index = *index;
 
-  if (menu && menu->event.key && menu->event.key(menu, key))
+  *index = (tui_index_t)
   {
-    return true;
-  }
+    .windows = windows,
+    .size    = size
+  };
 
-  if (tui->event.key && tui->event.key(tui, key))
+  for (size_t slot = 0; slot < old_index.size; slot++)
   {
-    return true;
+    tui_window_t* window = old_index.windows[slot];
+
+    if (window && window != &TUI_INDEX_REMOVED)
+    {
+      tui_index_window_add(index, window);
+    }
   }
 
-  return false;
+  free(old_index.windows);
+
+  return 0;
 }
 
 /*
- * Get the height of wrapped text given the width
+ * Add window to index
+ *
+ * If another window in the same scope has the same name,
+ * the window that was added first is kept
  */
-static inline int tui_text_h_get(char* text, int w)
+static inline int tui_index_window_add(tui_index_t* index, tui_window_t* window)
 {
-  size_t length = strlen(text);
+  if (!window->name) return 0;
 
-  if (length == 0 || w == 0)
+  // Keep the index at most half full
+  if ((index->count + 1) * 2 > index->size)
   {
-    return 0;
+    if (tui_index_resize(index, MAX(16, index->size * 2)) != 0)
+    {
+      return 1;
+    }
   }
 
-  int h = 1;
+  void* scope = tui_window_scope_get(window);
 
-  int x = 0;
-  int space_index = 0;
+  size_t length = strlen(window->name);
 
-  int last_space_index = space_index;
+  size_t mask = index->size - 1;
 
-  for (size_t index = 0; index < length; index++)
+  ssize_t free_slot = -1;
+
+  size_t slot = tui_index_hash(scope, window->name, length) & mask;
+
+  for (; index->windows[slot]; slot = (slot + 1) & mask)
   {
-    char letter = text[index];
+    tui_window_t* other = index->windows[slot];
 
-    if (letter == ' ')
+    if (other == &TUI_INDEX_REMOVED)
     {
-      space_index = index;
+      if (free_slot == -1) free_slot = slot;
     }
-
-    if (letter == '\n')
+    else if (tui_window_is_named(other, scope, window->name, length))
     {
-      x = 0;
-
-      h++;
+      return 0;
     }
-    else if (x >= w)
-    {
-      x = 0;
-
-      h++;
-
-      // Current word cannot be wrapped
-      if (space_index == last_space_index)
-      {
-        return -1;
-      }
+  }
 
-      index = space_index;
+  if (free_slot == -1)
+  {
+    free_slot = slot;
 
-      last_space_index = space_index;
-    }
-    else
-    {
-      x++;
-    }
+    index->count++;
   }
 
-  return h;
+  index->windows[free_slot] = window;
+
+  return 0;
 }
 
 /*
- * Get the width of wrapped text given the height
+ * Remove window from index
+ *
+ * If another window in the same scope has the same name,
+ * that window is added instead
  */
-static inline int tui_text_w_get(char* text, int h)
+static inline void tui_index_window_remove(tui_index_t* index, tui_window_t* window)
 {
-  int left  = 1;
-  int right = strlen(text);
+  if (!window->name || index->size == 0) return;
 
-  int min_w = right;
+  void* scope = tui_window_scope_get(window);
 
-  // Try every value between left and right, inclusive left == right
-  while (left <= right)
+  size_t length = strlen(window->name);
+
+  size_t mask = index->size - 1;
+
+  for (size_t slot = tui_index_hash(scope, window->name, length) & mask;; slot = (slot + 1) & mask)
   {
-    int mid = (left + right) / 2;
+    tui_window_t* other = index->windows[slot];
 
-    int curr_h = tui_text_h_get(text, mid);
+    if (!other) return;
 
-    // If width was too small to wrap, increase width
-    if (curr_h == -1)
+    if (other == window)
     {
-      left = mid + 1;
-    }
-    // If height got to large, increase width
-    else if (curr_h > h)
-    {
-      left = mid + 1;
+      index->windows[slot] = &TUI_INDEX_REMOVED;
+
+      break;
     }
-    else // If the height is smaller than max height, store current best width
+  }
+
+  // Get the windows that are in the same scope
+  tui_window_t** windows;
+  size_t         count;
+
+  if (window->parent)
+  {
+    windows = window->parent->children;
+    count   = window->parent->child_count;
+  }
+  else if (window->menu)
+  {
+    windows = window->menu->windows;
+    count   = window->menu->window_count;
+  }
+  else
+  {
+    windows = window->tui->windows;
+    count   = window->tui->window_count;
+  }
+
+  for (size_t other_index = 0; other_index < count; other_index++)
+  {
+    tui_window_t* other = windows[other_index];
+
+    if (other && other != window &&
+        tui_window_is_named(other, scope, window->name, length))
     {
-      min_w = mid;
-      right = mid - 1;
+      tui_index_window_add(index, other);
+
+      break;
     }
   }
-
-  return min_w;
 }
 
+static inline void tui_windows_free(tui_window_t*** windows, size_t* count, size_t* size);
+
 /*
- * Get widths of lines in text, regarding height
+ * Free parent window struct
  */
-static inline void tui_text_ws_get(int* ws, char* text, int h)
+static inline void tui_window_parent_free(tui_window_parent_t** window)
 {
-  int w = tui_text_w_get(text, h);
+  tui_windows_free(&(*window)->children, &(*window)->child_count, &(*window)->child_size);
 
-  size_t length = strlen(text);
+  tui_ncurses_window_free(&(*window)->head.window);
 
-  int y = 0;
-  int x = 0;
+  tui_arena_free((*window)->head.tui, *window);
 
-  int space_index = 0;
+  *window = NULL;
+}
 
-  for (size_t index = 0; (index < length) && (y < h); index++)
-  {
-    char letter = text[index];
+/*
+ * Free text window struct
+ */
+static inline void tui_window_text_free(tui_window_text_t** window)
+{
+  tui_ncurses_window_free(&(*window)->head.window);
 
-    if (letter == ' ')
-    {
-      space_index = index;
-    }
+  free((*window)->string);
 
-    if (letter == '\n')
-    {
-      ws[y++] = x;
+  free((*window)->text);
 
-      x = 0;
-    }
-    else if (x >= w)
-    {
-      // full line width - last partial word
-      ws[y++] = x - (index - space_index);
+  free((*window)->runs);
 
-      x = 0;
+  free((*window)->_wraps[0].ws);
 
-      index = space_index;
-    }
-    else
-    {
-      x++;
-    }
+  free((*window)->_wraps[1].ws);
 
-    // Store the width of last line
-    if (index + 1 == length)
-    {
-      ws[y] = x;
-    }
-  }
+#ifdef TUI_UTF8
+  free((*window)->_widths);
+
+  free((*window)->_glyphs);
+#endif // TUI_UTF8
+
+  tui_arena_free((*window)->head.tui, *window);
+
+  *window = NULL;
 }
 
 /*
- * Set cursor to x y
+ * Free grid window struct
  */
-static inline void tui_cursor_set(tui_t* tui, int x, int y)
+static inline void tui_window_grid_free(tui_window_grid_t** window)
 {
-  tui->cursor = (tui_cursor_t)
-  {
-    .x = x,
-    .y = y,
-    .is_active = true
-  };
+  tui_ncurses_window_free(&(*window)->head.window);
+
+  free((*window)->grid);
+
+  tui_arena_free((*window)->head.tui, *window);
+
+  *window = NULL;
 }
 
 /*
- * Extract ANSI code from string and increment index
+ * Free log window struct
  */
-static inline char* tui_string_ansi_extract(char* string, size_t length, size_t* index)
+static inline void tui_window_log_free(tui_window_log_t** window)
 {
-  char* ansi = malloc(sizeof(char) * (length - *index + 1));
-
-  if (!ansi)
-  {
-    return NULL;
-  }
-
-  size_t ansi_len = 0;
+  tui_ncurses_window_free(&(*window)->head.window);
 
-  (*index) += 2;
+  free((*window)->buffer);
 
-  while (*index < length && string[*index] != 'm')
-  {
-    ansi[ansi_len++] = string[(*index)++];
-  }
+  free((*window)->lines);
 
-  ansi[ansi_len] = '\0';
+  tui_arena_free((*window)->head.tui, *window);
 
-  return ansi;
+  *window = NULL;
 }
 
 /*
- * Handle ANSI escape code
- *
- * static tui_color_t color retains it's value between calls
+ * Free command struct
  */
-static inline void tui_string_ansi_handle(tui_window_t* window, char* ansi, int x, int y, int x_shift, int y_shift, tui_color_t* color)
+static inline void tui_command_free(tui_command_t** command)
 {
-  int code = atoi(ansi);
+  free((*command)->data);
 
-  // Reset everything
-  if (code == 0)
-  {
-    *color = window->_color;
-
-    wattroff(window->window, A_ATTRIBUTES);
-
-    tui_ncurses_window_color_on(window->window, window->_color);
-  }
-  // Cursor on
-  else if (code == 5)
-  {
-    // Only set the cursor if the text window is the active window
-    if (window->tui->window == (tui_window_t*) window)
-    {
-      tui_cursor_set(window->tui, window->_rect.x + x + x_shift, window->_rect.y + y + y_shift);
-    }
-  }
-  // Foreground color
-  else if (code >= 30 && code <= 37)
-  {
-    color->fg = code - 30;
-
-    tui_ncurses_window_color_on(window->window, *color);
-  }
-  // Background color
-  else if (code >= 40 && code <= 47)
-  {
-    color->bg = code - 40;
+  free(*command);
 
-    tui_ncurses_window_color_on(window->window, *color);
-  }
+  *command = NULL;
 }
 
 /*
- * Render text in rect in window
+ * Take the commands pushed onto the stack of queue,
+ * and append them to the list, in the order they were queued
  */
-static inline void tui_text_render(tui_window_text_t* window)
+static inline void tui_commands_take(tui_queue_t* queue)
 {
-  tui_window_t* head = &window->head;
-
-  tui_rect_t rect = head->_rect;
+  tui_command_t* stack = atomic_exchange(&queue->stack, NULL);
 
-  int h = tui_text_h_get(window->text, rect.w);
+  tui_command_t* commands = NULL;
 
-  // If text can't be displayed, don't render
-  if (h <= 0)
+  // Reverse the stack to queue order
+  while (stack)
   {
-    return;
-  }
+    tui_command_t* next = stack->next;
 
-  int ws[h];
+    stack->next = commands;
 
-  tui_text_ws_get(ws, window->text, h);
+    commands = stack;
 
-  // Store temporary color of letters
-  tui_color_t color = head->_color;
+    stack = next;
+  }
 
-  int x = 0;
-  int y = 0;
+  tui_command_t** end = &queue->list;
 
-  size_t length = strlen(window->string);
+  while (*end)
+  {
+    end = &(*end)->next;
+  }
 
-  int y_shift = MAX(0, (float) window->pos / 2.f * (rect.h - h));
+  *end = commands;
+}
 
-  for (size_t index = 0; index < length; index++)
-  {
-    char letter = window->string[index];
+/*
+ * Drop the queued commands of window, before the window is freed
+ *
+ * A command queued to the window after this would still refer to it,
+ * so a window must not be freed while other threads queue commands to it
+ */
+static inline void tui_window_commands_drop(tui_window_t* window)
+{
+  tui_queue_t* queue = window->tui->_queue;
 
-    int w = ws[y];
+  if (!queue) return;
 
-    int x_shift = MAX(0, (float) window->align / 2.f * (rect.w - w));
+  tui_commands_take(queue);
 
-    if (letter == '\033')
-    {
-      char* ansi = tui_string_ansi_extract(window->string, length, &index);
+  tui_command_t** link = &queue->list;
 
-      if (ansi)
-      {
-        tui_string_ansi_handle((tui_window_t*) window, ansi, x, y, x_shift, y_shift, &color);
+  while (*link)
+  {
+    tui_command_t* command = *link;
 
-        free(ansi);
-      }
-    }
-    else if (x >= w)
+    if (command->window == window)
     {
-      x = 0;
+      *link = command->next;
 
-      y++;
+      tui_command_free(&command);
     }
     else
     {
-      if (y + y_shift < rect.h && x + x_shift < rect.w)
-      {
-        if (window->is_secret)
-        {
-          letter = '*';
-        }
-
-        mvwaddch(head->window, y_shift + y, x_shift + x, letter);
-      }
-
-      x++;
+      link = &command->next;
     }
   }
 }
 
 /*
- * Extract just the text from string
- *
- * ANSI escape characters will be left out
+ * Free window struct
  */
-static inline char* tui_text_extract(char* string)
+static inline void tui_window_free(tui_window_t** window)
 {
-  if (!string)
+  if (!window || !(*window)) return;
+
+  if ((*window)->event.free)
   {
-    return NULL;
+    (*window)->event.free(*window);
   }
 
-  size_t length = strlen(string);
+  if ((*window)->tui)
+  {
+    tui_index_window_remove(&(*window)->tui->_index, *window);
 
-  char* text = malloc(sizeof(char) * (length + 1));
+    tui_window_commands_drop(*window);
+  }
 
-  if (!text)
+  switch ((*window)->type)
   {
-    return NULL;
+    case TUI_WINDOW_PARENT:
+      tui_window_parent_free((tui_window_parent_t**) window);
+      break;
+
+    case TUI_WINDOW_TEXT:
+      tui_window_text_free((tui_window_text_t**) window);
+      break;
+
+    case TUI_WINDOW_GRID:
+      tui_window_grid_free((tui_window_grid_t**) window);
+      break;
+
+    case TUI_WINDOW_LOG:
+      tui_window_log_free((tui_window_log_t**) window);
+      break;
+
+    default:
+      break;
   }
+}
 
-  size_t text_len = 0;
+/*
+ * Free windows
+ */
+static inline void tui_windows_free(tui_window_t*** windows, size_t* count, size_t* size)
+{
+  if (!windows || !(*windows)) return;
 
-  for (size_t index = 0; index < length; index++)
+  for (size_t index = 0; index < *count; index++)
   {
-    char letter = string[index];
-
-    if (letter == '\033')
-    {
-      while (index < length && string[index] != 'm') index++;
-    }
-    else
-    {
-      text[text_len++] = letter;
-    }
+    tui_window_free(&(*windows)[index]);
   }
 
-  text[text_len] = '\0';
+  free(*windows);
 
-  return text;
+  *windows = NULL;
+  *count   = 0;
+  *size    = 0;
 }
 
 /*
- * Render text window
+ * Free menu struct
  */
-static inline void tui_window_text_render(tui_window_text_t* window)
+static inline void tui_menu_free(tui_menu_t** menu)
 {
-  tui_window_t* head = &window->head;
+  if (!menu || !(*menu)) return;
 
-  WINDOW* parent = head->parent ? head->parent->head.window : stdscr;
+  tui_windows_free(&(*menu)->windows, &(*menu)->window_count, &(*menu)->window_size);
 
-  overwrite(parent, head->window);
+  tui_arena_free((*menu)->tui, *menu);
 
+  *menu = NULL;
+}
 
-  // Inherit color from window's ancestors
-  head->_color = tui_window_color_inherit((tui_window_t*) window, head->color);
+/*
+ * Free commands that are still queued, and the queue
+ */
+static inline void tui_commands_free(tui_t* tui)
+{
+  tui_queue_t* queue = tui->_queue;
 
-  tui_ncurses_window_color_on(head->window, head->_color);
+  if (!queue) return;
 
+  tui_commands_take(queue);
 
-  // Draw background
-  if (head->color.bg != TUI_COLOR_NONE)
-  {
-    tui_ncurses_window_fill(head->window);
-  }
+  tui_command_t* command = queue->list;
 
-  // Draw text
-  if (window->text)
+  while (command)
   {
-    tui_text_render(window);
+    tui_command_t* next = command->next;
+
+    tui_command_free(&command);
+
+    command = next;
   }
 
-  overwrite(head->window, parent);
+  free(queue);
+
+  tui->_queue = NULL;
 }
 
 /*
- * Render grid window
+ * Delete (free) tui struct and quit ncurses
  */
-static inline void tui_window_grid_render(tui_window_grid_t* window)
+void tui_delete(tui_t** tui)
 {
-  tui_window_t* head = &window->head;
+  if (!tui || !(*tui)) return;
 
-  WINDOW* parent = head->parent ? head->parent->head.window : stdscr;
+  // The queued commands are freed first, so the windows have none to drop
+  tui_commands_free(*tui);
 
-  overwrite(parent, head->window);
+  // Every window is freed, so the index is not kept up to date
+  free((*tui)->_index.windows);
 
+  (*tui)->_index = (tui_index_t) { 0 };
 
-  // Inherit color from window's ancestors
-  head->_color = tui_window_color_inherit((tui_window_t*) window, head->color);
+  for (size_t index = 0; index < (*tui)->menu_count; index++)
+  {
+    tui_menu_free(&(*tui)->menus[index]);
+  }
 
-  tui_ncurses_window_color_on(head->window, head->_color);
+  free((*tui)->menus);
 
+  tui_windows_free(&(*tui)->windows, &(*tui)->window_count, &(*tui)->window_size);
 
-  // Draw background
-  if (head->color.bg != TUI_COLOR_NONE)
+  for (size_t index = 0; index < (*tui)->_pool_count; index++)
   {
-    tui_ncurses_window_fill(head->window);
+    delwin((*tui)->_pool[index]);
   }
 
-  // Draw grid
-  if (window->grid)
-  {
-    int x_shift = MAX(0, (head->_rect.w - window->_size.w) / 2.f);
-    int y_shift = MAX(0, (head->_rect.h - window->_size.h) / 2.f);
+  free((*tui)->_pool);
 
-    for (int y = 0; y < window->_size.h; y++)
-    {
-      for (int x = 0; x < window->_size.w; x++)
-      {
-        int index = y * window->_size.w + x;
+  free((*tui)->_front);
 
-        tui_window_grid_square_t square = window->grid[index];
+  free((*tui)->timers);
 
-        char symbol = square.symbol ? square.symbol : ' ';
+  free((*tui)->fds);
 
+  if ((*tui)->_wake_fds[0] != -1)
+  {
+    close((*tui)->_wake_fds[0]);
+    close((*tui)->_wake_fds[1]);
+  }
 
-        tui_color_t color = tui_color_inherit(head->_color, square.color);
+  // The windows and menus in the arena are freed all at once
+  tui_arena_delete(*tui);
 
-        tui_ncurses_window_color_on(head->window, color);
+  free(*tui);
 
-        mvwaddch(head->window, y_shift + y, x_shift + x, symbol);
+  *tui = NULL;
 
-        tui_ncurses_window_color_off(head->window, color);
-      }
+  tui_ncurses_quit();
+}
+
+/*
+ * Trigger tui event
+ *
+ * Start by calling active window event handler
+ *
+ * If the event was handled, stop trigger events
+ *
+ * Otherwise, call parent event handler, and so on...
+ */
+bool tui_event(tui_t* tui, int key)
+{
+  tui_window_t* window = tui->window;
+
+  while (window)
+  {
+    if (window->event.key && window->event.key(window, key))
+    {
+      return true;
     }
+
+    window = (tui_window_t*) window->parent;
   }
 
-  overwrite(head->window, parent);
-}
+  tui_menu_t* menu = tui->menu;
+
+  if (menu && menu->event.key && menu->event.key(menu, key))
+  {
+    return true;
+  }
+
+  if (tui->event.key && tui->event.key(tui, key))
+  {
+    return true;
+  }
 
-static inline void tui_window_render(tui_window_t* window);
+  return false;
+}
 
 /*
- * Render parent window with all it's children
+ * Mark window and its ancestors as dirty
+ *
+ * The ancestors have to render again, to composite the window
+ *
+ * If the window is shown on the screen, the screen is also dirty
  */
-static inline void tui_window_parent_render(tui_window_parent_t* window)
+static inline void tui_window_parents_dirty_set(tui_window_t* window)
 {
-  tui_window_t* head = &window->head;
+  tui_window_t* base = window;
 
-  WINDOW* parent = head->parent ? head->parent->head.window : stdscr;
+  for (; window; window = (tui_window_t*) window->parent)
+  {
+    window->_is_dirty = true;
 
-  overwrite(parent, head->window);
+    base = window;
+  }
 
+  tui_t* tui = base ? base->tui : NULL;
 
-  // Inherit color from window's ancestors
-  head->_color = tui_window_color_inherit((tui_window_t*) window, head->color);
+  // Windows in inactive menus are not shown on the screen
+  if (tui && (!base->menu || base->menu == tui->menu))
+  {
+    tui->_is_dirty = true;
+  }
+}
 
-  tui_ncurses_window_color_on(head->window, head->_color);
+/*
+ * Mark window and its children recursivly as dirty
+ */
+static inline void tui_window_children_dirty_set(tui_window_t* window)
+{
+  if (!window) return;
 
+  window->_is_dirty = true;
 
-  // Draw background
-  if (head->color.bg != TUI_COLOR_NONE)
+  if (window->type == TUI_WINDOW_PARENT)
   {
-    // If the window has a shadow,
-    // adjust for the height and width difference
-    int shadow_h = window->has_shadow ? 1 : 0;
-    int shadow_w = window->has_shadow ? 2 : 0;
+    tui_window_parent_t* parent = (tui_window_parent_t*) window;
 
-    for (int y = 0; y < head->_rect.h - shadow_h; y++)
+    for (size_t index = 0; index < parent->child_count; index++)
     {
-      for (int x = 0; x < head->_rect.w - shadow_w; x++)
-      {
-        mvwaddch(head->window, y, x, ' ');
-      }
+      tui_window_children_dirty_set(parent->children[index]);
     }
   }
+}
 
-  // Draw border
-  tui_border_draw(window);
+/*
+ * Mark window, its children and its ancestors as dirty
+ */
+static inline void tui_window_tree_dirty_set(tui_window_t* window)
+{
+  tui_window_children_dirty_set(window);
 
-  // Draw shadow
-  tui_shadow_draw(window);
+  tui_window_parents_dirty_set(window);
+}
 
-  // Render children
-  for (size_t index = 0; index < window->child_count; index++)
+/*
+ * Mark window and its ancestors as layout dirty
+ *
+ * The size and rect of the window and its ancestors are calculated again
+ */
+static inline void tui_window_layout_dirty_set(tui_window_t* window)
+{
+  tui_t* tui = window ? window->tui : NULL;
+
+  for (; window; window = (tui_window_t*) window->parent)
   {
-    tui_window_t* child = window->children[index];
+    window->_is_layout_dirty = true;
+  }
 
-    if (child->_is_visable)
+  if (tui)
+  {
+    tui->_layout_gen++;
+  }
+}
+
+/*
+ * Mark windows and their children recursivly as layout dirty
+ */
+static inline void tui_windows_layout_dirty_set(tui_window_t** windows, size_t count)
+{
+  for (size_t index = 0; index < count; index++)
+  {
+    tui_window_t* window = windows[index];
+
+    window->_is_layout_dirty = true;
+
+    if (window->type == TUI_WINDOW_PARENT)
     {
-      tui_window_render(child);
+      tui_window_parent_t* parent = (tui_window_parent_t*) window;
+
+      tui_windows_layout_dirty_set(parent->children, parent->child_count);
     }
   }
-  
-  overwrite(head->window, parent);
 }
 
 /*
- * Render window
+ * Mark every window in tui and in every menu as layout dirty
  */
-static inline void tui_window_render(tui_window_t* window)
+static inline void tui_layout_dirty_set(tui_t* tui)
 {
-  if (window->event.render)
+  tui_windows_layout_dirty_set(tui->windows, tui->window_count);
+
+  for (size_t index = 0; index < tui->menu_count; index++)
   {
-    window->event.render(window);
+    tui_menu_t* menu = tui->menus[index];
+
+    tui_windows_layout_dirty_set(menu->windows, menu->window_count);
   }
 
-  switch (window->type)
-  {
-    case TUI_WINDOW_PARENT:
-      tui_window_parent_render((tui_window_parent_t*) window);
-      break;
+  tui->_layout_gen++;
+}
 
-    case TUI_WINDOW_TEXT:
-      tui_window_text_render((tui_window_text_t*) window);
-      break;
+/*
+ * Mark window as dirty, so it is rendered and calculated again
+ *
+ * Call this function after changing fields of window directly,
+ * for example border or is_vertical
+ */
+void tui_window_dirty_set(tui_window_t* window)
+{
+  tui_window_tree_dirty_set(window);
 
-    case TUI_WINDOW_GRID:
-      tui_window_grid_render((tui_window_grid_t*) window);
-      break;
+  tui_window_layout_dirty_set(window);
+}
 
-    default:
-      break;
+/*
+ * Check if is_hidden or rect of window has been changed directly
+ *
+ * If so, the window is layout dirty
+ */
+static inline void tui_window_layout_check(tui_window_t* window)
+{
+  if (window->is_hidden != window->_last_hidden ||
+      !tui_rect_is_equal(window->rect, window->_last_rect))
+  {
+    window->_last_hidden = window->is_hidden;
+    window->_last_rect   = window->rect;
+
+    tui_window_layout_dirty_set(window);
   }
 }
 
 /*
- * Render windows
+ * Check if color of window has been changed directly
+ *
+ * If so, the window and its children are dirty,
+ * and every inherited color is inherited again
  */
-static inline void tui_windows_render(tui_window_t** windows, size_t count)
+static inline void tui_window_color_check(tui_window_t* window)
 {
-  for (size_t index = count; index-- > 0;)
+  if (!tui_color_is_equal(window->color, window->_last_color))
   {
-    tui_window_t* window = windows[index];
+    window->_last_color = window->color;
 
-    if (window->_is_visable)
+    if (window->tui)
     {
-      tui_window_render(window);
+      window->tui->_color_gen++;
     }
+
+    tui_window_tree_dirty_set(window);
   }
 }
 
 /*
- * Calculate preliminary size of text window, based on text
- *
- * Size is temporarily stored in _rect
- *
- * Also, extract text from string
+ * Mark windows and their children as dirty
  */
-static inline void tui_window_text_size_calc(tui_window_text_t* window)
+static inline void tui_windows_dirty_set(tui_window_t** windows, size_t count)
 {
-  // Text window contains at least the cursor
-  window->head._rect = (tui_rect_t) { .w = 1, .h = 1 };
+  for (size_t index = 0; index < count; index++)
+  {
+    tui_window_children_dirty_set(windows[index]);
+  }
+}
 
-  free(window->text);
+/*
+ * Mark every tui window and menu window as dirty
+ *
+ * Call this function after changing fields of tui or menu directly
+ */
+void tui_dirty_set(tui_t* tui)
+{
+  tui_windows_dirty_set(tui->windows, tui->window_count);
 
-  window->text = tui_text_extract(window->string);
+  tui_menu_t* menu = tui->menu;
 
-  if (!window->text)
+  if (menu)
   {
-    window->head._rect = TUI_RECT_NONE;
+    tui_windows_dirty_set(menu->windows, menu->window_count);
   }
-  else if (!window->head.rect.is_none)
+
+  // What was drawn outside the windows, like windows of the last menu,
+  // is only filled again in composite mode if the whole screen is
+  tui->_is_damaged = true;
+
+  tui->_is_dirty = true;
+}
+
+/*
+ * Check if color of tui or active menu has changed
+ *
+ * If so, every window is dirty and every inherited color is inherited again
+ */
+static inline void tui_color_check(tui_t* tui)
+{
+  bool is_changed = !tui_color_is_equal(tui->color, tui->_last_color);
+
+  tui->_last_color = tui->color;
+
+  tui_menu_t* menu = tui->menu;
+
+  if (menu)
   {
-    window->head._rect = (tui_rect_t)
+    tui_color_t color = tui_color_inherit(tui->color, menu->color);
+
+    if (!tui_color_is_equal(color, menu->_color))
     {
-      .w = MAX(0, window->head.rect.w),
-      .h = MAX(0, window->head.rect.h)
-    };
+      menu->_color = color;
+
+      is_changed = true;
+    }
   }
-  else if (window->text && strlen(window->text) > 0)
+
+  if (is_changed)
   {
-    int h = tui_text_h_get(window->text, window->head.tui->size.w);
+    tui->_color_gen++;
+
+    tui_dirty_set(tui);
+  }
+}
 
-    int w = tui_text_w_get(window->text, h);
+/*
+ * Set _is_visable of window
+ *
+ * If the visability changed, the window and its ancestors are dirty
+ */
+static inline void tui_window_visable_set(tui_window_t* window, bool is_visable)
+{
+  if (window->_is_visable != is_visable)
+  {
+    window->_is_visable = is_visable;
 
-    window->head._rect = (tui_rect_t) { .w = w, .h = h};
+    tui_window_parents_dirty_set(window);
   }
 }
 
 /*
- * Calculate preliminary size of grid window, based on grid
+ * Get index of first letter in string that is a, between index and end
  *
- * Size is temporarily stored in _rect
+ * memchr of the C library is already vectorized
+ *
+ * Return end if there is no such letter
  */
-static inline void tui_window_grid_size_calc(tui_window_grid_t* window)
+static inline size_t tui_string_find(const char* string, size_t index, size_t end, char a)
 {
-  if (!window->grid)
+  if (index >= end) return end;
+
+  const char* letter = memchr(string + index, a, end - index);
+
+  return letter ? (size_t) (letter - string) : end;
+}
+
+/*
+ * Get index of first letter in string that is a or b, between index and end
+ *
+ * Return end if there is no such letter
+ */
+static inline size_t tui_string_find2(const char* string, size_t index, size_t end, char a, char b)
+{
+#if defined(TUI_SIMD_AVX2)
+  __m256i vector_a = _mm256_set1_epi8(a);
+  __m256i vector_b = _mm256_set1_epi8(b);
+
+  for (; index + 32 <= end; index += 32)
   {
-    window->head._rect = TUI_RECT_NONE;
+    __m256i chunk = _mm256_loadu_si256((const __m256i*) (string + index));
+
+    __m256i equal = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, vector_a), _mm256_cmpeq_epi8(chunk, vector_b));
+
+    uint32_t mask = _mm256_movemask_epi8(equal);
+
+    if (mask) return index + __builtin_ctz(mask);
   }
-  else if (window->head.rect.is_none)
+#elif defined(TUI_SIMD_SSE2)
+  __m128i vector_a = _mm_set1_epi8(a);
+  __m128i vector_b = _mm_set1_epi8(b);
+
+  for (; index + 16 <= end; index += 16)
   {
-    window->head._rect = (tui_rect_t)
-    {
-      .w = window->size.w,
-      .h = window->size.h,
-    };
+    __m128i chunk = _mm_loadu_si128((const __m128i*) (string + index));
+
+    __m128i equal = _mm_or_si128(_mm_cmpeq_epi8(chunk, vector_a), _mm_cmpeq_epi8(chunk, vector_b));
+
+    uint32_t mask = _mm_movemask_epi8(equal);
+
+    if (mask) return index + __builtin_ctz(mask);
   }
-  else
+#elif defined(TUI_SIMD_NEON)
+  uint8x16_t vector_a = vdupq_n_u8(a);
+  uint8x16_t vector_b = vdupq_n_u8(b);
+
+  for (; index + 16 <= end; index += 16)
   {
-    window->head._rect = (tui_rect_t)
-    {
-      .w = MAX(0, window->head.rect.w),
-      .h = MAX(0, window->head.rect.h)
-    };
+    uint8x16_t chunk = vld1q_u8((const uint8_t*) (string + index));
+
+    uint8x16_t equal = vorrq_u8(vceqq_u8(chunk, vector_a), vceqq_u8(chunk, vector_b));
+
+    // Every letter becomes 4 bits of the mask
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+
+    if (mask) return index + (__builtin_ctzll(mask) >> 2);
+  }
+#endif
+
+  // The letters that are left, or every letter without vector instructions
+  for (; index < end; index++)
+  {
+    if (string[index] == a || string[index] == b) return index;
   }
+
+  return end;
 }
 
-static inline void tui_window_size_calc(tui_window_t* window);
+#ifdef TUI_UTF8
 
 /*
- * Calculate preliminary size of parent window, based on children
+ * Decode the UTF-8 glyph at the start of string
+ *
+ * An invalid or cut off glyph is decoded as U+FFFD, from one byte
  *
- * Size is temporarily stored in _rect
+ * RETURN (size_t count) amount of bytes of glyph
  */
-static inline void tui_window_parent_size_calc(tui_window_parent_t* parent)
+static inline size_t tui_utf8_decode(const char* string, size_t length, wchar_t* glyph)
 {
-  // Calculate size of every child window downwards
-  for (size_t index = 0; index < parent->child_count; index++)
+  unsigned char letter = string[0];
+
+  size_t count = (letter < 0x80) ? 1 :
+                 ((letter >> 5) == 0x06) ? 2 :
+                 ((letter >> 4) == 0x0e) ? 3 :
+                 ((letter >> 3) == 0x1e) ? 4 : 0;
+
+  if (count == 0 || count > length)
   {
-    tui_window_t* child = parent->children[index];
+    *glyph = 0xfffd;
 
-    tui_window_size_calc(child);
+    return 1;
   }
 
-  parent->head._rect = (tui_rect_t) { 0 };
+  wchar_t value = (count == 1) ? letter : (letter & (0x7f >> count));
 
-  if (!parent->head.rect.is_none)
+  for (size_t index = 1; index < count; index++)
   {
-    parent->head._rect = (tui_rect_t)
+    if ((string[index] & 0xc0) != 0x80)
     {
-      .w = MAX(0, parent->head.rect.w),
-      .h = MAX(0, parent->head.rect.h)
-    };
+      *glyph = 0xfffd;
+
+      return 1;
+    }
+
+    value = (value << 6) | (string[index] & 0x3f);
   }
-  else if (parent->children && parent->child_count)
-  {
-    tui_size_t align_size = { 0 };
-    tui_size_t max_size   = { 0 };
 
-    size_t align_count = 0;
+  *glyph = value;
 
-    for (size_t index = 0; index < parent->child_count; index++)
-    {
-      tui_window_t* child = parent->children[index];
+  return count;
+}
 
-      if (!child->is_contain)
-      {
-        max_size.w = MAX(max_size.w, child->_rect.w);
-        max_size.h = MAX(max_size.h, child->_rect.h);
-      }
+/*
+ * Get the amount of cells of glyph
+ *
+ * Control characters take one cell, like in ASCII text
+ */
+static inline int tui_glyph_width_get(wchar_t glyph)
+{
+  int width = wcwidth(glyph);
 
-      if (!child->rect.is_none)
-      {
-        max_size.w = MAX(max_size.w, child->rect.x + child->rect.w);
-        max_size.h = MAX(max_size.h, child->rect.y + child->rect.h);
-      }
-      else if (parent->is_vertical)
-      {
-        align_count++;
-
-        align_size.h += child->_rect.h;
+  return (width < 0) ? 1 : width;
+}
 
-        if (!child->is_contain)
-        {
-          align_size.w = MAX(align_size.w, child->_rect.w);
-        }
-      }
-      else
-      {
-        align_count++;
+/*
+ * Get the amount of bytes of the glyphs of UTF-8 string that fit in cells
+ *
+ * The first glyph is always counted, and its cells are stored in width
+ */
+static inline size_t tui_utf8_fit_get(const char* string, size_t length, int cells, int* width)
+{
+  size_t index = 0;
 
-        align_size.w += child->_rect.w;
+  *width = 0;
 
-        if (!child->is_contain)
-        {
-          align_size.h = MAX(align_size.h, child->_rect.h);
-        }
-      }
-    }
+  while (index < length)
+  {
+    wchar_t glyph = (unsigned char) string[index];
 
-    if (parent->has_gap)
-    {
-      if (parent->is_vertical)
-      {
-        align_size.h += (align_count - 1) * 1;
-      }
-      else
-      {
-        align_size.w += (align_count - 1) * 2;
-      }
-    }
+    size_t count = (glyph < 0x80) ? 1 : tui_utf8_decode(string + index, length - index, &glyph);
 
-    if (parent->has_padding)
-    {
-      align_size.w += 4;
-      align_size.h += 2;
-    }
+    int glyph_w = (glyph < 0x80) ? 1 : tui_glyph_width_get(glyph);
 
-    if (parent->border.is_active)
-    {
-      align_size.w += 2;
-      align_size.h += 2;
-    }
+    if (index > 0 && *width + glyph_w > cells) break;
 
-    if (parent->has_shadow)
-    {
-      align_size.w += 2;
-      align_size.h += 1;
-    }
+    *width += glyph_w;
 
-    parent->head._rect = (tui_rect_t)
-    {
-      .h = MAX(max_size.h, align_size.h),
-      .w = MAX(max_size.w, align_size.w)
-    };
+    index += count;
   }
+
+  return index;
 }
 
 /*
- * Calculate preliminary size of window, based on content
+ * Decode text of text window into glyphs, and store the cell width of every glyph
  *
- * Size is temporarily stored in _rect
+ * The width is stored at the first byte of the glyph, flagged with TUI_GLYPH_START,
+ * and the other bytes of the glyph have no width. The text is only decoded here,
+ * when it is set, and not when it is wrapped or rendered
  */
-static inline void tui_window_size_calc(tui_window_t* window)
+static inline void tui_window_text_glyphs_update(tui_window_text_t* window)
 {
-  switch (window->type)
-  {
-    case TUI_WINDOW_PARENT:
-      tui_window_parent_size_calc((tui_window_parent_t*) window);
-      break;
+  window->_is_utf8 = false;
 
-    case TUI_WINDOW_TEXT:
-      tui_window_text_size_calc((tui_window_text_t*) window);
-      break;
+  char* text = window->text;
 
-    case TUI_WINDOW_GRID:
-      tui_window_grid_size_calc((tui_window_grid_t*) window);
-      break;
+  size_t length = window->text_len;
 
-    default:
-      break;
-  }
-}
+  if (!text) return;
 
-/*
- * Calculate the preliminary sizes of windows
- */
-static inline void tui_windows_size_calc(tui_window_t** windows, size_t count)
-{
-  for (size_t index = 0; index < count; index++)
-  {
-    tui_window_size_calc(windows[index]);
-  }
-}
+  // ASCII text has one cell for every byte, so no glyphs are needed
+  size_t index = 0;
 
-/*
- * Get starting y of aligned parent children
- */
-static inline int tui_child_y_get(tui_window_parent_t* parent)
-{
-  int y = 0;
+  while (index < length && !(text[index] & 0x80)) index++;
 
-  if (parent->border.is_active)
-  {
-    y += 1;
-  }
+  if (index == length) return;
 
-  if (parent->has_padding)
+  if (length > window->_glyph_size)
   {
-    y += 1;
-  }
+    TUI_STATS_ADD(alloc_count, 2);
 
-  return y;
-}
+    uint8_t* widths = realloc(window->_widths, sizeof(uint8_t) * length);
 
-/*
- * Get starting x of aligned parent children
- */
-static inline int tui_child_x_get(tui_window_parent_t* parent)
-{
-  int x = 0;
+    if (widths) window->_widths = widths;
 
-  if (parent->border.is_active)
-  {
-    x += 1;
-  }
+    wchar_t* glyphs = realloc(window->_glyphs, sizeof(wchar_t) * length);
 
-  if (parent->has_padding)
-  {
-    x += 2;
+    if (glyphs) window->_glyphs = glyphs;
+
+    if (!widths || !glyphs) return;
+
+    window->_glyph_size = length;
   }
 
-  return x;
-}
+  size_t glyph_count = 0;
 
-/*
- * Get w of vertically aligned child
- */
-static inline int tui_child_w_get(tui_window_t* child, int max_w)
-{
-  if (child->is_contain || child->w_grow)
+  for (index = 0; index < length;)
   {
-    return max_w;
+    wchar_t glyph;
+
+    size_t count = tui_utf8_decode(text + index, length - index, &glyph);
+
+    window->_widths[index] = TUI_GLYPH_START | tui_glyph_width_get(glyph);
+
+    for (size_t rest = 1; rest < count; rest++)
+    {
+      window->_widths[index + rest] = 0;
+    }
+
+    window->_glyphs[glyph_count++] = glyph;
+
+    index += count;
   }
 
-  return MIN(max_w, child->_rect.w);
+  window->_is_utf8 = true;
 }
 
+#endif // TUI_UTF8
+
 /*
- * Get h of horizontally aligned child
+ * Get cell widths of text of text window, or NULL if every byte is one cell
  */
-static inline int tui_child_h_get(tui_window_t* child, int max_h)
+static inline uint8_t* tui_window_text_widths_get(tui_window_text_t* window)
 {
-  if (child->is_contain || child->h_grow)
+#ifdef TUI_UTF8
+  if (window->_is_utf8)
   {
-    return max_h;
+    return window->_widths;
   }
+#endif // TUI_UTF8
+
+  (void) window;
 
-  return MIN(max_h, child->_rect.h);
+  return NULL;
 }
 
 /*
- * Calculate rect of vertically aligned child
+ * Wrap text in lines given the width, in a single pass
  *
- * align_count and align_index must be int, because they are used in integer arithmetic
+ * Lines are wrapped at the last space, and the widths of the lines
+ * are stored in ws, if ws is not NULL
+ *
+ * If widths is not NULL, it has the cell width at every byte of the text
+ *
+ * Return the height of the wrapped text, or -1 if a word cannot be wrapped
  */
-static inline void tui_child_vert_rect_calc(tui_rect_t* rect, tui_window_parent_t* parent, tui_window_t* child, tui_size_t max_size, tui_size_t align_size, int align_count, int* align_index, int grow_count, int* grow_index)
+static inline int tui_text_lines_get(int* ws, char* text, const uint8_t* widths, size_t length, int w)
 {
-  if (*align_index == 0)
+  if (length == 0 || w == 0)
   {
-    rect->y = tui_child_y_get(parent);
+    return 0;
   }
 
-  rect->x = tui_child_x_get(parent);
+  int y = 0;
+  int x = 0;
 
-  int h_space = (max_size.h - align_size.h);
+  size_t space_index = 0;
 
-  int h = child->_rect.h;
+  size_t last_space_index = space_index;
 
-  int h_gap = 0;
+  // Width of the line before the last space
+  int space_x = 0;
 
-  // Make every child the same height
-  if (parent->align == TUI_ALIGN_EVENLY)
+  for (size_t index = 0; index < length; index++)
   {
-    // The total height of all children combined
-    int total_h = max_size.h;
-
-    if (parent->has_gap)
+    // Skip the letters that fit on the line and are not spaces or new lines
+    if (!widths && x < w)
     {
-      // Add this gap after current child
-      h_gap += 1;
+      size_t end = tui_string_find2(text, index, MIN(length, index + (w - x)), ' ', '\n');
 
-      // Account for the gap between each child window
-      total_h = MAX(0, max_size.h - (align_count - 1) * 1);
-    }
+      x += end - index;
 
-    h = total_h / align_count;
+      index = end;
 
-    // Grow first windows a little bit more to fill out extra padding
-    if (total_h - h * align_count > *align_index)
-    {
-      h += 1;
-    }
-  }
-  else if (child->h_grow)
-  {
-    if (parent->has_gap)
-    {
-      // Add this gap after current child
-      h_gap += 1;
-      
-      // recalculate h_space as the extra grown height between windows
-      h_space = MAX(0, h_space - (align_count - 1) * 1); 
+      if (index >= length) break;
     }
 
-    int gap = h_space / grow_count;
+    char letter = text[index];
 
-    h += gap;
+    int letter_w = widths ? (widths[index] & ~TUI_GLYPH_START) : 1;
 
-    // Grow first windows a little bit more to fill out extra padding
-    if (h_space - gap * grow_count > *grow_index)
+    if (letter == ' ')
     {
-      h += 1;
-    }
+      space_index = index;
 
-    (*grow_index)++;
-  }
-  // If other children is grown, but not this one
-  else if (grow_count > 0)
-  {
-    if (parent->has_gap)
-    {
-      // Add this gap after current child
-      h_gap += 1;
+      space_x = x;
     }
-  }
-  else if (parent->align == TUI_ALIGN_BETWEEN)
-  {
-    // Add this gap after current child
-    int gap = (float) h_space / (float) (align_count - 1);
-
-    h_gap += gap;
 
-    // Add extra gap between first windows
-    if (h_space - gap * (align_count - 1) > *align_index)
+    if (letter == '\n')
     {
-      h_gap += 1;
-    }
-  }
-  else if (parent->align == TUI_ALIGN_AROUND)
-  {
-    // Add this gap before current child
-    int gap = (float) h_space / (float) (align_count + 1);
+      if (ws) ws[y] = x;
 
-    int rest = h_space - gap * (align_count + 1);
+      y++;
 
-    if (*align_index == 0 && rest > 0)
+      x = 0;
+
+      // Spaces before the new line cannot be used to wrap
+      last_space_index = space_index;
+    }
+    else if (letter_w == 0)
     {
-      rect->y += (float) rest / 2.f;
+      // The rest of a glyph, or a glyph that is drawn
+      // on the glyph before, is on the same line
+      continue;
     }
-
-    rect->y += gap;
-  }
-  else if (parent->align < 3) // START, CENTER, END
-  {
-    if (*align_index == 0) // First child to align
+    else if (x + letter_w > w)
     {
-      // Add this gap before current child
-      if (parent->has_gap)
+      // Current word cannot be wrapped
+      if (space_index == last_space_index)
       {
-        h_space = MAX(0, h_space - (align_count - 1) * 1); 
+        return -1;
       }
 
-      rect->y += (float) parent->align / 2.f * h_space;
-    }
-
-    if (parent->has_gap)
-    {
-      // Add this gap after current child
-      h_gap += 1;
-    }
-  }
+      // full line width - last partial word
+      if (ws) ws[y] = space_x;
 
-  int w = tui_child_w_get(child, max_size.w);
+      y++;
 
-  // If there is no space left for child, use what space is left
-  int end_y = tui_child_y_get(parent);
+      // The letters after the space continues on the next line
+      x = x - space_x - 1 + letter_w;
 
-  if (rect->y + h > max_size.h + end_y)
-  {
-    if (child->is_atomic)
-    {
-      h = 0;
+      last_space_index = space_index;
     }
     else
     {
-      h = max_size.h + end_y - rect->y;
+      x += letter_w;
     }
   }
 
-  rect->w = w;
-  rect->h = h;
-
-  rect->x += (float) parent->pos / 2.f * (max_size.w - w);
-
-  (*align_index)++;
-
-  child->_rect = *rect;
+  // Store the width of last line
+  if (ws) ws[y] = x;
 
-  rect->y += child->_rect.h + h_gap;
+  return y + 1;
 }
 
 /*
- * Calculate rect of horizontally aligned child
+ * Get the smallest width of wrapped text given the height
+ *
+ * The text is known to fit in width w, in h lines
  */
-static inline void tui_child_horiz_rect_calc(tui_rect_t* rect, tui_window_parent_t* parent, tui_window_t* child, tui_size_t max_size, tui_size_t align_size, int align_count, int* align_index, int grow_count, int* grow_index)
+static inline int tui_text_w_get(char* text, const uint8_t* widths, size_t length, int w, int h)
 {
-  if (*align_index == 0)
-  {
-    rect->x = tui_child_x_get(parent);
-  }
-
-  rect->y = tui_child_y_get(parent);
-
-  int w_space = (max_size.w - align_size.w);
-
-  int w = child->_rect.w;
+  int left  = 1;
+  int right = w;
 
-  int w_gap = 0;
+  int min_w = right;
 
-  // Make every child the same width
-  if (parent->align == TUI_ALIGN_EVENLY)
+  // Try every value between left and right, inclusive left == right
+  while (left <= right)
   {
-    // The total width of all children combined
-    int total_w = max_size.w;
+    int mid = (left + right) / 2;
 
-    if (parent->has_gap)
-    {
-      // Add this gap after current child
-      w_gap += 2;
+    int curr_h = tui_text_lines_get(NULL, text, widths, length, mid);
 
-      // Account for the gap between each child window
-      total_w = MAX(0, max_size.w - (align_count - 1) * 2);
+    // If width was too small to wrap, increase width
+    if (curr_h == -1)
+    {
+      left = mid + 1;
     }
-
-    w = total_w / align_count;
-
-    // Grow first windows a little bit more to fill out extra padding
-    if (total_w - w * align_count > *align_index)
+    // If height got to large, increase width
+    else if (curr_h > h)
     {
-      w += 1;
+      left = mid + 1;
     }
-  }
-  else if (child->w_grow)
-  {
-    if (parent->has_gap)
+    else // If the height is smaller than max height, store current best width
     {
-      // Add this gap after current child
-      w_gap += 2;
-
-      // Get the total available space for all children to grow
-      w_space = MAX(0, w_space - (align_count - 1) * 2); 
+      min_w = mid;
+      right = mid - 1;
     }
+  }
 
-    // Get the available space for this child to grow
-    // (all children grow by the same amount)
-    int gap = w_space / grow_count;
+  return min_w;
+}
 
-    w += gap;
+/*
+ * Set cursor to x y
+ */
+static inline void tui_cursor_set(tui_t* tui, int x, int y)
+{
+  tui->cursor = (tui_cursor_t)
+  {
+    .x = x,
+    .y = y,
+    .is_active = true
+  };
+}
 
-    // Grow first windows a little bit more to fill out extra padding
-    if (w_space - gap * grow_count > *grow_index)
-    {
-      w += 1;
-    }
+/*
+ * Handle ANSI escape code
+ */
+static inline void tui_string_ansi_handle(tui_window_t* window, int code, int x, int y, int x_shift, int y_shift, tui_color_t* color)
+{
+  // Reset everything
+  if (code == 0)
+  {
+    *color = window->_color;
 
-    (*grow_index)++;
+    wattroff(window->window, A_ATTRIBUTES);
+
+    tui_window_color_on(window);
   }
-  // If other children is grown, but not this one
-  else if (grow_count > 0)
+  // Cursor on
+  else if (code == 5)
   {
-    if (parent->has_gap)
+    // Only set the cursor if the text window is the active window
+    if (window->tui->window == (tui_window_t*) window)
     {
-      // Add this gap after current child
-      w_gap += 2;
+      tui_cursor_set(window->tui, window->_rect.x + x + x_shift, window->_rect.y + y + y_shift);
     }
   }
-  else if (parent->align == TUI_ALIGN_BETWEEN)
+  // Foreground color
+  else if (code >= 30 && code <= 37)
   {
-    // Add this gap after current child
-    int gap = (float) w_space / (float) (align_count - 1);
-
-    w_gap += gap;
+    color->fg = code - 30;
 
-    // Add extra gap between first windows
-    if (w_space - gap * (align_count - 1) > *align_index)
-    {
-      w_gap += 1;
-    }
+    tui_ncurses_window_color_on(window->window, *color);
   }
-  else if (parent->align == TUI_ALIGN_AROUND)
+  // Background color
+  else if (code >= 40 && code <= 47)
   {
-    int gap = (float) w_space / (float) (align_count + 1);
+    color->bg = code - 40;
 
-    int rest = w_space - gap * (align_count + 1);
+    tui_ncurses_window_color_on(window->window, *color);
+  }
+}
 
-    if (*align_index == 0 && rest > 0)
+/*
+ * Get text of text window wrapped in width
+ *
+ * The wrap is calculated once and reused for the same text and width,
+ * so the layout and the render share the same result
+ */
+static inline tui_text_wrap_t* tui_window_text_wrap_get(tui_window_text_t* window, int w)
+{
+  for (size_t index = 0; index < 2; index++)
+  {
+    tui_text_wrap_t* wrap = &window->_wraps[index];
+
+    if (wrap->is_valid && wrap->w == w)
     {
-      rect->x += (float) rest / 2.f;
+      return wrap;
     }
-
-    rect->x += gap;
   }
-  else if (parent->align < 3) // START, CENTER, END
+
+  // Replace the oldest wrap
+  tui_text_wrap_t* wrap = &window->_wraps[window->_wrap_index];
+
+  window->_wrap_index = (window->_wrap_index + 1) % 2;
+
+  wrap->is_valid = false;
+
+  uint8_t* widths = tui_window_text_widths_get(window);
+
+  int h = tui_text_lines_get(NULL, window->text, widths, window->text_len, w);
+
+  int min_w = window->text_len;
+
+  if (h > 0)
   {
-    if (*align_index == 0) // First child to align
+    if ((size_t) h > wrap->ws_size)
     {
-      // Add this gap before current child
-      if (parent->has_gap)
+      TUI_STATS_ADD(alloc_count, 1);
+
+      int* ws = realloc(wrap->ws, sizeof(int) * h);
+
+      if (!ws)
       {
-        // Remove all space between windows 
-        // not including padding around the border
-        w_space = MAX(0, w_space - (align_count - 1) * 2); 
+        return NULL;
       }
 
-      rect->x += (float) parent->align / 2.f * w_space;
-    }
+      wrap->ws = ws;
 
-    if (parent->has_gap)
-    {
-      // Add this gap after current child
-      w_gap += 2;
+      wrap->ws_size = h;
     }
-  }
 
-  int h = tui_child_h_get(child, max_size.h);
+    tui_text_lines_get(wrap->ws, window->text, widths, window->text_len, w);
 
-  // If there is no space left for child, use what space is left
-  int end_x = tui_child_x_get(parent);
+    tui_text_wrap_t* other = &window->_wraps[window->_wrap_index];
 
-  if (rect->x + w > max_size.w + end_x)
-  {
-    if (child->is_atomic)
+    // The smallest width only depends on the height,
+    // so it is reused from the other wrap with the same height
+    if (other->is_valid && other->h == h)
     {
-      w = 0;
+      min_w = other->min_w;
     }
     else
     {
-      w = max_size.w + end_x - rect->x;
-    }
-  }
+      // The text wraps the same in the width of its widest line,
+      // so the smallest width is not wider than that
+      int max_w = 1;
 
-  rect->w = w;
-  rect->h = h;
+      for (int y = 0; y < h; y++)
+      {
+        max_w = MAX(max_w, wrap->ws[y]);
+      }
 
-  rect->y += (float) parent->pos / 2.f * (max_size.h - h);
+      min_w = tui_text_w_get(window->text, widths, window->text_len, max_w, h);
+    }
 
-  (*align_index)++;
+    if (min_w != w)
+    {
+      tui_text_lines_get(wrap->ws, window->text, widths, window->text_len, min_w);
+    }
+  }
 
-  child->_rect = *rect;
+  wrap->w        = w;
+  wrap->h        = h;
+  wrap->min_w    = min_w;
+  wrap->is_valid = true;
 
-  rect->x += child->_rect.w + w_gap;
+  return wrap;
 }
 
 /*
- * Calculate rect of aligned child
+ * Get the part of window inside the screen and its parent,
+ * relative to the window
+ *
+ * Only this part is drawn, the rest can't be seen
  */
-static inline void tui_child_rect_calc(tui_rect_t* rect, tui_window_parent_t* parent, tui_window_t* child, tui_size_t max_size, tui_size_t align_size, int align_count, int* align_index, int grow_count, int* grow_index)
+static inline tui_rect_t tui_window_clip_get(tui_window_t* window)
 {
-  if (parent->is_vertical)
-  {
-    tui_child_vert_rect_calc(rect, parent, child, max_size, align_size, align_count, align_index, grow_count, grow_index);
-  }
-  else
-  {
-    tui_child_horiz_rect_calc(rect, parent, child, max_size, align_size, align_count, align_index, grow_count, grow_index);
-  }
+  tui_rect_t clip = window->_clip;
+
+  clip.x -= window->_rect.x;
+  clip.y -= window->_rect.y;
+
+  return clip;
 }
 
+#ifdef TUI_UTF8
+
 /*
- * Get rect for window from rect with potential negative values
+ * Draw the glyphs of text window from index, until the next run or the end of the line
+ *
+ * The glyphs are drawn at once, and only the glyphs between the cells min_x and max_w.
+ * If y is -1, the glyphs are outside the clip of the window and not drawn
+ *
+ * index and glyph are left at the last byte and glyph that was drawn
  */
-static inline tui_rect_t tui_window_rect_get(tui_rect_t rect, int parent_w, int parent_h)
+static inline void tui_text_glyphs_draw(tui_window_text_t* window, size_t run, size_t* index, size_t* glyph, int* x, int w, int min_x, int max_w, int y, int x_shift)
 {
-  if (rect.h <= 0)
-  {
-    rect.h = MAX(0, parent_h + rect.h);
-  }
+  size_t end = window->text_len;
 
-  if (rect.w <= 0)
+  if (run < window->run_count)
   {
-    rect.w = MAX(0, parent_w + rect.w);
+    end = MIN(end, window->runs[run].index);
   }
 
-  if (rect.x < 0)
-  {
-    rect.x = MAX(0, parent_w + rect.x);
-  }
+  size_t next = *index;
 
-  if (rect.y < 0)
-  {
-    rect.y = MAX(0, parent_h + rect.y);
-  }
+  int cells = 0;
 
-  return rect;
-}
+  size_t glyph_count   = 0;
+  size_t hidden_count  = 0;
+  int    hidden_cells  = 0;
+  size_t visable_count = 0;
+  int    visable_cells = 0;
 
-/*
- * Hide window by setting _is_visable to false
- *
- * If window is parent, hide children recursivly
- */
-static inline void tui_window_set_invisable(tui_window_t* window)
-{
-  if (window)
+  while (next < end)
   {
-    window->_is_visable = false;
+    uint8_t width = window->_widths[next];
 
-    if (window->type == TUI_WINDOW_PARENT)
+    if (width & TUI_GLYPH_START)
     {
-      tui_window_parent_t* parent = (tui_window_parent_t*) window;
+      int glyph_w = width & ~TUI_GLYPH_START;
 
-      for (size_t index = 0; index < parent->child_count; index++)
+      // The first glyph is always drawn, so the text moves forward
+      if (next > *index && *x + cells + glyph_w > w) break;
+
+      // Glyphs that start left of the clip are left out
+      if (*x + cells < min_x)
       {
-        tui_window_t* child = parent->children[index];
+        hidden_count = glyph_count + 1;
+        hidden_cells = cells + glyph_w;
+      }
+      else if (*x + cells + glyph_w <= max_w)
+      {
+        visable_count = glyph_count + 1;
+        visable_cells = cells + glyph_w;
+      }
 
-        tui_window_set_invisable(child);
+      cells += glyph_w;
+
+      glyph_count++;
+    }
+
+    next++;
+  }
+
+  if (y >= 0 && visable_count > hidden_count)
+  {
+    WINDOW* ncurses_window = window->head.window;
+
+    if (window->is_secret)
+    {
+      for (int cell = hidden_cells; cell < visable_cells; cell++)
+      {
+        TUI_DRAW(mvwaddch(ncurses_window, y, x_shift + *x + cell, '*'));
       }
     }
+    else
+    {
+      TUI_DRAW(mvwaddnwstr(ncurses_window, y, x_shift + *x + hidden_cells, window->_glyphs + *glyph + hidden_count, visable_count - hidden_count));
+    }
   }
+
+  *x += cells;
+
+  *glyph += glyph_count;
+
+  // The index is incremented by the loop
+  *index = next - 1;
 }
 
+#endif // TUI_UTF8
+
 /*
- * Get maximum content size of parent
+ * Render text in rect in window
  */
-static inline tui_size_t tui_max_size_get(tui_window_parent_t* parent)
+static inline void tui_text_render(tui_window_text_t* window)
 {
-  tui_size_t max_size =
-  {
-    .w = parent->head._rect.w,
-    .h = parent->head._rect.h
-  };
+  tui_window_t* head = &window->head;
 
-  if (parent->has_padding)
-  {
-    max_size.w -= 4;
-    max_size.h -= 2;
-  }
+  tui_rect_t rect = head->_rect;
 
-  if (parent->border.is_active)
-  {
-    max_size.w -= 2;
-    max_size.h -= 2;
-  }
+  tui_text_wrap_t* wrap = tui_window_text_wrap_get(window, rect.w);
 
-  if (parent->has_shadow)
+  // If text can't be displayed, don't render
+  if (!wrap || wrap->h <= 0)
   {
-    max_size.w -= 2;
-    max_size.h -= 1;
+    return;
   }
 
-  return max_size;
-}
+  int h = wrap->h;
 
-/*
- * Calculate rect of parent's children
- *
- * Make use of the temporarily stored sizes in _rect
- */
-static inline void tui_children_rect_calc(tui_window_parent_t* parent)
-{
-  tui_size_t max_size = tui_max_size_get(parent);
+  int* ws = wrap->ws;
 
-  tui_size_t align_size = { 0 };
+  // Only the letters inside the clip are drawn
+  tui_rect_t clip = tui_window_clip_get(head);
 
-  size_t align_count = 0;
-  size_t grow_count  = 0;
+  // Store temporary color of letters
+  tui_color_t color = head->_color;
 
-  for (size_t index = 0; index < parent->child_count; index++)
+  int x = 0;
+  int y = 0;
+
+  size_t length = window->text_len;
+
+  size_t run = 0;
+
+#ifdef TUI_UTF8
+  // Index of the glyph at index in the text
+  size_t glyph = 0;
+#endif // TUI_UTF8
+
+  int y_shift = MAX(0, (float) window->pos / 2.f * (rect.h - h));
+
+  // The ANSI codes after the last letter are also handled
+  for (size_t index = 0; index <= length; index++)
   {
-    tui_window_t* child = parent->children[index];
+    int w = ws[y];
 
-    if (!child->rect.is_none)
-    {
-      child->_is_visable = !child->is_hidden;
+    int x_shift = MAX(0, (float) window->align / 2.f * (rect.w - w));
 
-      continue;
-    }
+    bool is_row_visable = (y_shift + y >= clip.y && y_shift + y < clip.y + clip.h);
 
-    if (child->is_hidden)
+    // Handle the ANSI codes that apply from this letter
+    for (; run < window->run_count && window->runs[run].index == index; run++)
     {
-      child->_is_visable = false;
+      tui_string_ansi_handle(head, window->runs[run].code, x, y, x_shift, y_shift, &color);
     }
-    else if (parent->is_vertical)
-    {
-      if (child->is_atomic &&
-         (align_size.h + child->_rect.h > max_size.h ||
-          child->_rect.w > max_size.w))
-      {
-        child->_is_visable = false;
 
-        continue;
-      }
+    if (index == length) break;
 
-      child->_is_visable = true;
+    // The rest of the text is below the clip, without any ANSI codes to handle
+    if (y_shift + y >= clip.y + clip.h && run >= window->run_count) break;
 
-      align_count++;
+    if (x >= w)
+    {
+      x = 0;
 
-      align_size.h += child->_rect.h;
+      y++;
 
-      align_size.w = MAX(align_size.w, child->_rect.w);
+#ifdef TUI_UTF8
+      // The space or new line at the end of the line is a glyph
+      glyph++;
+#endif // TUI_UTF8
 
-      if (child->h_grow)
-      {
-        grow_count++;
-      }
+      continue;
     }
-    else
+
+#ifdef TUI_UTF8
+    if (window->_is_utf8)
     {
-      if (child->is_atomic &&
-         (align_size.w + child->_rect.w > max_size.w ||
-          child->_rect.h > max_size.h))
-      {
-        child->_is_visable = false;
+      tui_text_glyphs_draw(window, run, &index, &glyph, &x, w, clip.x - x_shift, clip.x + clip.w - x_shift, is_row_visable ? y_shift + y : -1, x_shift);
 
-        continue;
-      }
+      continue;
+    }
+#endif // TUI_UTF8
 
-      child->_is_visable = true;
+    // Draw the letters until the next run or the end of the line at once
+    size_t end = MIN(length, index + (w - x));
 
-      align_count++;
+    if (run < window->run_count)
+    {
+      end = MIN(end, window->runs[run].index);
+    }
 
-      align_size.w += child->_rect.w;
+    int x1 = MAX(x_shift + x, clip.x);
+    int x2 = MIN(x_shift + x + (int) (end - index), clip.x + clip.w);
 
-      align_size.h = MAX(align_size.h, child->_rect.h);
+    if (is_row_visable && x1 < x2)
+    {
+      char* letters = window->text + index + (x1 - x_shift - x);
 
-      if (child->w_grow)
+      if (window->is_secret)
       {
-        grow_count++;
+        for (int letter = 0; letter < x2 - x1; letter++)
+        {
+          TUI_DRAW(mvwaddch(head->window, y_shift + y, x1 + letter, '*'));
+        }
+      }
+      else
+      {
+        TUI_DRAW(mvwaddnstr(head->window, y_shift + y, x1, letters, x2 - x1));
       }
     }
+
+    x += end - index;
+
+    index = end - 1;
   }
+}
 
-  align_size.w = MIN(align_size.w, max_size.w);
-  align_size.h = MIN(align_size.h, max_size.h);
+/*
+ * Copy what is under window to its ncurses WINDOW*
+ *
+ * If the window shares the cells of the screen, what is under the window is already there
+ */
+static inline void tui_window_under_copy(tui_window_t* window)
+{
+  if (window->_is_shared) return;
 
-  // x and y is stored temporarily for children
-  tui_rect_t rect = { 0 };
+  WINDOW* parent = window->parent ? window->parent->head.window : stdscr;
 
-  int align_index = 0;
-  int grow_index  = 0;
+  overwrite(parent, window->window);
 
-  for (size_t index = 0; index < parent->child_count; index++)
+  TUI_STATS_ADD(copy_count, 1);
+}
+
+/*
+ * Copy ncurses WINDOW* of window to what is under it
+ *
+ * If the window shares the cells of the screen, the window was drawn directly onto the screen
+ */
+static inline void tui_window_over_copy(tui_window_t* window)
+{
+  if (window->_is_shared) return;
+
+  WINDOW* parent = window->parent ? window->parent->head.window : stdscr;
+
+  overwrite(window->window, parent);
+
+  TUI_STATS_ADD(copy_count, 1);
+}
+
+/*
+ * Render text window
+ */
+static inline void tui_window_text_render(tui_window_text_t* window)
+{
+  tui_window_t* head = &window->head;
+
+  tui_window_under_copy(head);
+
+
+  // Inherit color from window's ancestors
+  tui_window_color_get(head);
+
+  tui_window_color_on(head);
+
+
+  // Draw background
+  if (head->color.bg != TUI_COLOR_NONE)
   {
-    tui_window_t* child = parent->children[index];
+    tui_ncurses_window_fill(head->window, tui_window_clip_get(head));
+  }
 
-    if (!child->_is_visable)
-    {
-      tui_window_set_invisable(child);
+  // Draw text
+  if (window->text)
+  {
+    tui_text_render(window);
+  }
 
-      continue;
-    }
+  tui_window_over_copy(head);
+}
 
-    if (child->rect.is_none)
-    {
-      tui_child_rect_calc(&rect, parent, child, max_size, align_size, align_count, &align_index, grow_count, &grow_index);
-    }
-    else
-    {
-      tui_rect_t parent_rect = parent->head._rect;
+/*
+ * Draw squares of grid window inside rect
+ *
+ * Each row is built as a buffer of symbols with their color pair,
+ * and the pair is only looked up when the color changes
+ */
+static inline void tui_window_grid_squares_draw(tui_window_grid_t* window, tui_rect_t rect)
+{
+  tui_window_t* head = &window->head;
 
-      if (parent->has_shadow)
-      {
-        parent_rect.w -= 2;
-        parent_rect.h -= 1;
-      }
+  int x_shift = MAX(0, (head->_rect.w - window->_size.w) / 2.f);
+  int y_shift = MAX(0, (head->_rect.h - window->_size.h) / 2.f);
 
-      child->_rect = tui_window_rect_get(child->rect, parent_rect.w, parent_rect.h);
-    }
+  // Only the squares inside the clip are drawn
+  tui_rect_t clip = tui_window_clip_get(head);
 
-    if (child->_rect.w == 0 || child->_rect.h == 0)
-    {
-      tui_window_set_invisable(child);
-    }
-    else
-    {
-      child->_is_visable = true;
+  clip.x -= x_shift;
+  clip.y -= y_shift;
 
-      // Move child window into parent window
-      child->_rect.x += parent->head._rect.x;
-      child->_rect.y += parent->head._rect.y;
+  rect = tui_rect_intersect_get(rect, clip);
 
-      child->window = tui_ncurses_window_update(child->window, child->_rect);
+  if (rect.is_none) return;
 
-      if (child->type == TUI_WINDOW_PARENT)
+  chtype row[MAX(1, rect.w)];
+
+  tui_color_t last_color = { 0 };
+
+  chtype pair_attr = 0;
+
+  bool has_color = false;
+
+  for (int y = rect.y; y < rect.y + rect.h; y++)
+  {
+    for (int x = rect.x; x < rect.x + rect.w; x++)
+    {
+      tui_window_grid_square_t square = window->grid[y * window->_size.w + x];
+
+      unsigned char symbol = square.symbol ? square.symbol : ' ';
+
+      if (!has_color ||
+          square.color.fg != last_color.fg ||
+          square.color.bg != last_color.bg)
       {
-        tui_children_rect_calc((tui_window_parent_t*) child);
+        tui_color_t color = tui_color_inherit(head->_color, square.color);
+
+        pair_attr = COLOR_PAIR(tui_color_pair_get(color));
+
+        last_color = square.color;
+
+        has_color = true;
       }
+
+      row[x - rect.x] = symbol | pair_attr;
     }
+
+    TUI_DRAW(mvwaddchnstr(head->window, y_shift + y, x_shift + rect.x, row, rect.w));
   }
 }
 
 /*
- * Calculate rect of window
- *
- * The content of this function is similar to
- * the content of the for loop in tui_children_rect_calc
+ * Render grid window
  */
-static inline void tui_window_rect_calc(tui_window_t* window, int w, int h)
+static inline void tui_window_grid_render(tui_window_grid_t* window)
 {
-  if (window->is_hidden)
-  {
-    tui_window_set_invisable(window);
+  tui_window_t* head = &window->head;
 
-    return;
-  }
+  tui_window_under_copy(head);
 
-  if (!window->rect.is_none)
+
+  // Inherit color from window's ancestors
+  tui_window_color_get(head);
+
+  tui_window_color_on(head);
+
+
+  // Draw background
+  if (head->color.bg != TUI_COLOR_NONE)
   {
-    window->_rect = tui_window_rect_get(window->rect, w, h);
+    tui_ncurses_window_fill(head->window, tui_window_clip_get(head));
   }
 
-  if (window->_rect.w == 0 || window->_rect.h == 0)
+  // Draw grid
+  if (window->grid)
   {
-    tui_window_set_invisable(window);
+    tui_window_grid_squares_draw(window, (tui_rect_t)
+    {
+      .w = window->_size.w,
+      .h = window->_size.h
+    });
   }
-  else
-  {
-    window->_is_visable = true;
 
-    window->window = tui_ncurses_window_update(window->window, window->_rect);
+  window->_damage = TUI_RECT_NONE;
 
-    if(window->type == TUI_WINDOW_PARENT)
-    {
-      tui_children_rect_calc((tui_window_parent_t*) window);
-    }
-  }
+  tui_window_over_copy(head);
 }
 
 /*
- * Calculate rects of windows
+ * Render only the changed squares of grid window
+ *
+ * The rest of the ncurses WINDOW* still contains what was rendered last time
  */
-static inline void tui_windows_rect_calc(tui_window_t** windows, size_t count, int w, int h)
+static inline void tui_window_grid_damage_render(tui_window_grid_t* window)
 {
-  for (size_t index = 0; index < count; index++)
+  tui_window_t* head = &window->head;
+
+  if (window->grid)
   {
-    tui_window_rect_calc(windows[index], w, h);
+    tui_window_grid_squares_draw(window, window->_damage);
   }
+
+  window->_damage = TUI_RECT_NONE;
+
+  tui_window_over_copy(head);
 }
 
 /*
- * Calculate rect of every tui window
+ * Get line in log window, where index 0 is the oldest line
+ */
+static inline tui_log_line_t* tui_window_log_line_get(tui_window_log_t* window, size_t index)
+{
+  return &window->lines[(window->_line_start + index) % window->line_max];
+}
+
+/*
+ * Get the index after ANSI escape code at index of string
  *
- * tui base windows must have fixed rect (for now)
+ * An escape code is "\033[", codes separated by ';' and 'm'.
+ * A lone or unterminated '\033' is not an escape code, so only it is skipped
  */
-static inline void tui_rect_calc(tui_t* tui)
+static inline size_t tui_ansi_end_get(const char* string, size_t index, size_t length)
 {
-  int w = tui->size.w;
-  int h = tui->size.h;
+  size_t end = index + 1;
 
-  tui_windows_rect_calc(tui->windows, tui->window_count, w, h);
+  if (end >= length || string[end] != '[')
+  {
+    return index + 1;
+  }
 
-  tui_menu_t* menu = tui->menu;
+  end++;
 
-  if (menu)
+  while (end < length && ((string[end] >= '0' && string[end] <= '9') || string[end] == ';'))
   {
-    tui_windows_rect_calc(menu->windows, menu->window_count, w, h);
+    end++;
   }
+
+  return (end < length && string[end] == 'm') ? end + 1 : index + 1;
 }
 
 /*
- * Calculate sizes of tui windows and menu windows
+ * Handle the codes of ANSI escape code of log line, from index to end
  */
-static inline void tui_size_calc(tui_t* tui)
+static inline void tui_log_ansi_handle(tui_window_t* window, const char* string, size_t index, size_t end, tui_color_t* color)
 {
-  tui_windows_size_calc(tui->windows, tui->window_count);
-
-  tui_menu_t* menu = tui->menu;
+  // Skip the escape character and '['
+  index += 2;
 
-  if (menu)
+  while (index < end)
   {
-    tui_windows_size_calc(menu->windows, menu->window_count);
+    // An empty code is the same as 0
+    int code = 0;
+
+    while (string[index] >= '0' && string[index] <= '9')
+    {
+      code = code * 10 + (string[index++] - '0');
+    }
+
+    // The cursor is not used in log window
+    if (code != 5)
+    {
+      tui_string_ansi_handle(window, code, 0, 0, 0, 0, color);
+    }
+
+    // Skip ';' or the final 'm'
+    index++;
+  }
+}
+
+/*
+ * Get the amount of bytes of the letters of string that fit in cells,
+ * and store the cells of the letters in width
+ *
+ * The first letter is always counted, so every row has at least one letter
+ */
+static inline size_t tui_log_fit_get(const char* string, size_t length, int cells, int* width)
+{
+#ifdef TUI_UTF8
+  return tui_utf8_fit_get(string, length, cells, width);
+#else // TUI_UTF8
+  (void) string;
+
+  size_t count = MIN(length, (size_t) MAX(1, cells));
+
+  *width = count;
+
+  return count;
+#endif // TUI_UTF8
+}
+
+/*
+ * Draw letters of log line at column x of row y
+ *
+ * The letters outside of the columns of clip are left out
+ */
+static inline void tui_log_row_draw(tui_window_t* window, int x, int y, const char* string, size_t count, tui_rect_t clip)
+{
+  int clip_end = clip.x + clip.w;
+
+  // Skip the letters that start left of the clip
+  while (count > 0 && x < clip.x)
+  {
+    int letter_w;
+
+    size_t letter = tui_log_fit_get(string, count, 0, &letter_w);
+
+    string += letter;
+    count  -= letter;
+
+    x += letter_w;
+  }
+
+  if (count == 0 || x >= clip_end) return;
+
+  int count_w;
+
+  count = tui_log_fit_get(string, count, clip_end - x, &count_w);
+
+  // A wide glyph at the end of the clip is left out
+  if (count_w > clip_end - x) return;
+
+  TUI_DRAW(mvwaddnstr(window->window, y, x, string, count));
+}
+
+/*
+ * Walk line of log window, wrapped at width w, starting at row y
+ *
+ * If is_drawn, the line is drawn, and rows outside of the clip of the window
+ * are left out. Otherwise the line is only measured. The same walk is used for both,
+ * so the line takes up as many rows as it is measured to
+ *
+ * RETURN (int rows)
+ * - The amount of rows of the line, even an empty line takes up one row
+ */
+static inline int tui_log_line_walk(tui_window_log_t* window, tui_log_line_t* line, int w, int y, bool is_drawn)
+{
+  tui_window_t* head = &window->head;
+
+  tui_rect_t clip = tui_window_clip_get(head);
+
+  char* string = window->buffer + line->index;
+
+  size_t length = line->length;
+
+  // Every line starts with the color of the window
+  tui_color_t color = head->_color;
+
+  if (is_drawn)
+  {
+    tui_string_ansi_handle(head, 0, 0, 0, 0, 0, &color);
+  }
+
+  int x = 0;
+
+  int rows = 1;
+
+  size_t index = 0;
+
+  while (index < length)
+  {
+    if (string[index] == '\033')
+    {
+      size_t end = tui_ansi_end_get(string, index, length);
+
+      if (is_drawn && end > index + 1)
+      {
+        tui_log_ansi_handle(head, string, index, end, &color);
+      }
+
+      index = end;
+
+      continue;
+    }
+
+    // Walk the letters until the next escape code, a row at a time
+    size_t end = tui_string_find(string, index, length, '\033');
+
+    while (index < end)
+    {
+      if (x >= w)
+      {
+        x = 0;
+
+        rows++;
+      }
+
+      int row = y + rows - 1;
+
+      if (is_drawn && row >= clip.y + clip.h) return rows;
+
+      int count_w;
+
+      size_t count = tui_log_fit_get(string + index, end - index, w - x, &count_w);
+
+      // A wide glyph that doesn't fit at the end of the row is wrapped
+      if (x > 0 && count_w > w - x)
+      {
+        x = w;
+
+        continue;
+      }
+
+      if (is_drawn && row >= clip.y)
+      {
+        tui_log_row_draw(head, x, row, string + index, count, clip);
+      }
+
+      x += count_w;
+
+      index += count;
+    }
+  }
+
+  return rows;
+}
+
+/*
+ * Get the amount of rows of line of log window, wrapped at width w
+ *
+ * The rows are kept until the line is wrapped at another width
+ */
+static inline int tui_window_log_line_h_get(tui_window_log_t* window, tui_log_line_t* line, int w)
+{
+  if (line->_wrap_w != w)
+  {
+    line->_wrap_h = tui_log_line_walk(window, line, w, 0, false);
+
+    line->_wrap_w = w;
+  }
+
+  return line->_wrap_h;
+}
+
+/*
+ * Draw line of log window, starting at row y
+ *
+ * The line is wrapped at the width of the window,
+ * and rows and columns outside of the clip of the window are left out
+ */
+static inline void tui_log_line_draw(tui_window_log_t* window, tui_log_line_t* line, int y)
+{
+  int w = window->head._rect.w;
+
+  if (w <= 0) return;
+
+  tui_log_line_walk(window, line, w, y, true);
+}
+
+/*
+ * Render log window
+ *
+ * Only the visable lines are drawn, from the bottom and up
+ */
+static inline void tui_window_log_render(tui_window_log_t* window)
+{
+  tui_window_t* head = &window->head;
+
+  tui_window_under_copy(head);
+
+
+  // Inherit color from window's ancestors
+  tui_window_color_get(head);
+
+  tui_window_color_on(head);
+
+
+  // Draw background
+  if (head->color.bg != TUI_COLOR_NONE)
+  {
+    tui_ncurses_window_fill(head->window, tui_window_clip_get(head));
+  }
+
+  int w = head->_rect.w;
+
+  tui_rect_t clip = tui_window_clip_get(head);
+
+  // Draw lines, from the bottom and up, until the top of the clip
+  int y = head->_rect.h;
+
+  for (size_t count = window->scroll; (count < window->line_count) && (y > clip.y) && (w > 0); count++)
+  {
+    tui_log_line_t* line = tui_window_log_line_get(window, window->line_count - 1 - count);
+
+    int line_h = tui_window_log_line_h_get(window, line, w);
+
+    y -= line_h;
+
+    tui_log_line_draw(window, line, y);
+  }
+
+  tui_window_over_copy(head);
+}
+
+static inline void tui_window_render(tui_window_t* window, tui_rect_t* damage);
+
+#ifdef TUI_PROFILE
+
+/*
+ * Store render time of window in stats of frame
+ *
+ * The time of parent window includes its children,
+ * so only other windows can be the slowest window
+ */
+static inline void tui_window_stats_update(tui_window_t* window, int64_t time)
+{
+  window->_render_us = time;
+
+  frame_stats.window_count++;
+
+  if (window->type != TUI_WINDOW_PARENT &&
+      (!frame_stats.slow_window || time > frame_stats.slow_time))
+  {
+    frame_stats.slow_window = window;
+    frame_stats.slow_time   = time;
+  }
+}
+
+#endif // TUI_PROFILE
+
+/*
+ * Render parent window with all it's children
+ *
+ * damage is the part of the screen where what is under the window has changed,
+ * which is also under the children
+ */
+static inline void tui_window_parent_render(tui_window_parent_t* window, tui_rect_t damage)
+{
+  tui_window_t* head = &window->head;
+
+  tui_window_under_copy(head);
+
+
+  // Inherit color from window's ancestors
+  tui_window_color_get(head);
+
+  tui_window_color_on(head);
+
+
+  // Draw background
+  if (head->color.bg != TUI_COLOR_NONE)
+  {
+    // If the window has a shadow,
+    // adjust for the height and width difference
+    int shadow_h = window->has_shadow ? 1 : 0;
+    int shadow_w = window->has_shadow ? 2 : 0;
+
+    tui_rect_t rect = tui_rect_intersect_get((tui_rect_t)
+    {
+      .w = head->_rect.w - shadow_w,
+      .h = head->_rect.h - shadow_h
+    }, tui_window_clip_get(head));
+
+    if (!rect.is_none)
+    {
+      tui_ncurses_window_fill(head->window, rect);
+    }
+  }
+
+  // Draw border
+  tui_border_draw(window);
+
+  // Draw shadow
+  tui_shadow_draw(window);
+
+  // Render children
+  for (size_t index = 0; index < window->child_count; index++)
+  {
+    tui_window_t* child = window->children[index];
+
+    if (child->_is_visable)
+    {
+      tui_window_render(child, &damage);
+    }
+    else
+    {
+      // What a hidden child covered last time is now what is under it
+      damage = tui_rect_union_get(damage, child->_clip);
+
+      child->_clip = TUI_RECT_NONE;
+    }
+  }
+  
+  tui_window_over_copy(head);
+}
+
+/*
+ * Render window
+ *
+ * A clean window is only composited from its ncurses WINDOW*,
+ * which still contains what was rendered last time
+ *
+ * The WINDOW* also contains what was under the window last time,
+ * so a clean window over damage is rendered again.
+ * damage is the part of the screen where what is under the window has changed,
+ * and the part of the screen that the window changes is added to it
+ *
+ * A window sharing the cells of the screen contains nothing else,
+ * so in composite mode damage already contains every window that is rendered again
+ *
+ * Only the part of the window inside the screen and its parent is drawn
+ */
+static inline void tui_window_render(tui_window_t* window, tui_rect_t* damage)
+{
+  tui_rect_t screen_rect = (tui_rect_t)
+  {
+    .w = window->tui->size.w,
+    .h = window->tui->size.h
+  };
+
+  tui_rect_t parent_clip = window->parent ? window->parent->head._clip : screen_rect;
+
+  // What the window covered last time
+  tui_rect_t last_clip = window->_clip;
+
+  window->_clip = tui_rect_intersect_get(window->_rect, parent_clip);
+
+  // A window outside the screen or its parent can't be seen,
+  // so neither the window nor its children are rendered
+  if (window->_clip.is_none || !window->window)
+  {
+    *damage = tui_rect_union_get(*damage, last_clip);
+
+    return;
+  }
+
+  bool is_under_changed = !tui_rect_intersect_get(window->_clip, *damage).is_none;
+
+  if (!window->_is_dirty && !is_under_changed)
+  {
+    // Grid window with changed squares only draws those squares
+    if (window->type == TUI_WINDOW_GRID &&
+        !((tui_window_grid_t*) window)->_damage.is_none)
+    {
+      tui_window_grid_damage_render((tui_window_grid_t*) window);
+
+      *damage = tui_rect_union_get(*damage, window->_clip);
+
+      return;
+    }
+
+    tui_window_over_copy(window);
+
+    return;
+  }
+
+  // The children of the window are over the same damage as the window
+  tui_rect_t under_damage = *damage;
+
+  *damage = tui_rect_union_get(*damage, tui_rect_union_get(last_clip, window->_clip));
+
+  // A window sharing the cells of the screen draws over its children
+  if (window->_is_shared)
+  {
+    under_damage = *damage;
+  }
+
+  // The flag is cleared before rendering,
+  // so changes made while rendering is rendered next time
+  window->_is_dirty = false;
+
+#ifdef TUI_PROFILE
+  int64_t start = tui_time_us_get();
+#endif // TUI_PROFILE
+
+  if (window->event.render)
+  {
+    window->event.render(window);
+  }
+
+  switch (window->type)
+  {
+    case TUI_WINDOW_PARENT:
+      tui_window_parent_render((tui_window_parent_t*) window, under_damage);
+      break;
+
+    case TUI_WINDOW_TEXT:
+      tui_window_text_render((tui_window_text_t*) window);
+      break;
+
+    case TUI_WINDOW_GRID:
+      tui_window_grid_render((tui_window_grid_t*) window);
+      break;
+
+    case TUI_WINDOW_LOG:
+      tui_window_log_render((tui_window_log_t*) window);
+      break;
+
+    default:
+      break;
+  }
+
+#ifdef TUI_PROFILE
+  tui_window_stats_update(window, tui_time_us_get() - start);
+#endif // TUI_PROFILE
+}
+
+/*
+ * Render windows
+ *
+ * damage is the part of the screen that has changed under the windows
+ */
+static inline void tui_windows_render(tui_window_t** windows, size_t count, tui_rect_t* damage)
+{
+  for (size_t index = count; index-- > 0;)
+  {
+    tui_window_t* window = windows[index];
+
+    if (window->_is_visable)
+    {
+      tui_window_render(window, damage);
+    }
+    else
+    {
+      // What a hidden window covered last time is now what is under it
+      *damage = tui_rect_union_get(*damage, window->_clip);
+
+      window->_clip = TUI_RECT_NONE;
+    }
+  }
+}
+
+/*
+ * Calculate preliminary size of text window, based on text
+ *
+ * Size is temporarily stored in _calc_size
+ */
+static inline void tui_window_text_size_calc(tui_window_text_t* window)
+{
+  // Text window contains at least the cursor
+  window->head._calc_size = (tui_size_t) { .w = 1, .h = 1 };
+
+  if (!window->text)
+  {
+    window->head._calc_size = TUI_SIZE_NONE;
+  }
+  else if (!window->head.rect.is_none)
+  {
+    window->head._calc_size = (tui_size_t)
+    {
+      .w = MAX(0, window->head.rect.w),
+      .h = MAX(0, window->head.rect.h)
+    };
+  }
+  else if (window->text_len > 0)
+  {
+    tui_text_wrap_t* wrap = tui_window_text_wrap_get(window, window->head.tui->size.w);
+
+    if (wrap)
+    {
+      window->head._calc_size = (tui_size_t) { .w = wrap->min_w, .h = wrap->h };
+    }
+  }
+}
+
+/*
+ * Calculate preliminary size of grid window, based on grid
+ *
+ * Size is temporarily stored in _calc_size
+ */
+static inline void tui_window_grid_size_calc(tui_window_grid_t* window)
+{
+  if (!window->grid)
+  {
+    window->head._calc_size = TUI_SIZE_NONE;
+  }
+  else if (window->head.rect.is_none)
+  {
+    window->head._calc_size = (tui_size_t)
+    {
+      .w = window->size.w,
+      .h = window->size.h,
+    };
+  }
+  else
+  {
+    window->head._calc_size = (tui_size_t)
+    {
+      .w = MAX(0, window->head.rect.w),
+      .h = MAX(0, window->head.rect.h)
+    };
+  }
+}
+
+/*
+ * Calculate preliminary size of log window
+ *
+ * The size of a log window doesn't depend on the lines
+ *
+ * Size is temporarily stored in _calc_size
+ */
+static inline void tui_window_log_size_calc(tui_window_log_t* window)
+{
+  if (!window->buffer)
+  {
+    window->head._calc_size = TUI_SIZE_NONE;
+  }
+  else if (window->head.rect.is_none)
+  {
+    window->head._calc_size = (tui_size_t) { .w = 1, .h = 1 };
+  }
+  else
+  {
+    window->head._calc_size = (tui_size_t)
+    {
+      .w = MAX(0, window->head.rect.w),
+      .h = MAX(0, window->head.rect.h)
+    };
+  }
+}
+
+static inline void tui_window_size_calc(tui_window_t* window);
+
+/*
+ * Calculate preliminary size of parent window, based on children
+ *
+ * Size is temporarily stored in _calc_size
+ */
+static inline void tui_window_parent_size_calc(tui_window_parent_t* parent)
+{
+  // Calculate size of every child window downwards
+  for (size_t index = 0; index < parent->child_count; index++)
+  {
+    tui_window_t* child = parent->children[index];
+
+    tui_window_size_calc(child);
+  }
+
+  parent->head._calc_size = TUI_SIZE_NONE;
+
+  if (!parent->head.rect.is_none)
+  {
+    parent->head._calc_size = (tui_size_t)
+    {
+      .w = MAX(0, parent->head.rect.w),
+      .h = MAX(0, parent->head.rect.h)
+    };
+  }
+  else if (parent->children && parent->child_count)
+  {
+    tui_size_t align_size = { 0 };
+    tui_size_t max_size   = { 0 };
+
+    size_t align_count = 0;
+
+    for (size_t index = 0; index < parent->child_count; index++)
+    {
+      tui_window_t* child = parent->children[index];
+
+      if (!child->is_contain)
+      {
+        max_size.w = MAX(max_size.w, child->_calc_size.w);
+        max_size.h = MAX(max_size.h, child->_calc_size.h);
+      }
+
+      if (!child->rect.is_none)
+      {
+        max_size.w = MAX(max_size.w, child->rect.x + child->rect.w);
+        max_size.h = MAX(max_size.h, child->rect.y + child->rect.h);
+      }
+      else if (parent->is_vertical)
+      {
+        align_count++;
+
+        align_size.h += child->_calc_size.h;
+
+        if (!child->is_contain)
+        {
+          align_size.w = MAX(align_size.w, child->_calc_size.w);
+        }
+      }
+      else
+      {
+        align_count++;
+
+        align_size.w += child->_calc_size.w;
+
+        if (!child->is_contain)
+        {
+          align_size.h = MAX(align_size.h, child->_calc_size.h);
+        }
+      }
+    }
+
+    if (parent->has_gap)
+    {
+      if (parent->is_vertical)
+      {
+        align_size.h += (align_count - 1) * 1;
+      }
+      else
+      {
+        align_size.w += (align_count - 1) * 2;
+      }
+    }
+
+    if (parent->has_padding)
+    {
+      align_size.w += 4;
+      align_size.h += 2;
+    }
+
+    if (parent->border.is_active)
+    {
+      align_size.w += 2;
+      align_size.h += 2;
+    }
+
+    if (parent->has_shadow)
+    {
+      align_size.w += 2;
+      align_size.h += 1;
+    }
+
+    parent->head._calc_size = (tui_size_t)
+    {
+      .h = MAX(max_size.h, align_size.h),
+      .w = MAX(max_size.w, align_size.w)
+    };
+  }
+}
+
+/*
+ * Calculate preliminary size of window, based on content
+ *
+ * Size is temporarily stored in _calc_size
+ */
+static inline void tui_window_size_calc(tui_window_t* window)
+{
+  // If nothing has changed, the window still has its calculated size
+  if (!window->_is_layout_dirty) return;
+
+  switch (window->type)
+  {
+    case TUI_WINDOW_PARENT:
+      tui_window_parent_size_calc((tui_window_parent_t*) window);
+      break;
+
+    case TUI_WINDOW_TEXT:
+      tui_window_text_size_calc((tui_window_text_t*) window);
+      break;
+
+    case TUI_WINDOW_GRID:
+      tui_window_grid_size_calc((tui_window_grid_t*) window);
+      break;
+
+    case TUI_WINDOW_LOG:
+      tui_window_log_size_calc((tui_window_log_t*) window);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*
+ * Calculate the preliminary sizes of windows
+ */
+static inline void tui_windows_size_calc(tui_window_t** windows, size_t count)
+{
+  for (size_t index = 0; index < count; index++)
+  {
+    tui_window_size_calc(windows[index]);
+  }
+}
+
+/*
+ * Get starting y of aligned parent children
+ */
+static inline int tui_child_y_get(tui_window_parent_t* parent)
+{
+  int y = 0;
+
+  if (parent->border.is_active)
+  {
+    y += 1;
+  }
+
+  if (parent->has_padding)
+  {
+    y += 1;
+  }
+
+  return y;
+}
+
+/*
+ * Get starting x of aligned parent children
+ */
+static inline int tui_child_x_get(tui_window_parent_t* parent)
+{
+  int x = 0;
+
+  if (parent->border.is_active)
+  {
+    x += 1;
+  }
+
+  if (parent->has_padding)
+  {
+    x += 2;
+  }
+
+  return x;
+}
+
+/*
+ * Get w of vertically aligned child
+ */
+static inline int tui_child_w_get(tui_window_t* child, int max_w)
+{
+  if (child->is_contain || child->w_grow)
+  {
+    return max_w;
+  }
+
+  return MIN(max_w, child->_calc_size.w);
+}
+
+/*
+ * Get h of horizontally aligned child
+ */
+static inline int tui_child_h_get(tui_window_t* child, int max_h)
+{
+  if (child->is_contain || child->h_grow)
+  {
+    return max_h;
+  }
+
+  return MIN(max_h, child->_calc_size.h);
+}
+
+/*
+ * Calculate rect of vertically aligned child
+ *
+ * align_count and align_index must be int, because they are used in integer arithmetic
+ */
+static inline void tui_child_vert_rect_calc(tui_rect_t* rect, tui_window_parent_t* parent, tui_window_t* child, tui_size_t max_size, tui_size_t align_size, int align_count, int* align_index, int grow_count, int* grow_index)
+{
+  if (*align_index == 0)
+  {
+    rect->y = tui_child_y_get(parent);
+  }
+
+  rect->x = tui_child_x_get(parent);
+
+  int h_space = (max_size.h - align_size.h);
+
+  int h = child->_calc_size.h;
+
+  int h_gap = 0;
+
+  // Make every child the same height
+  if (parent->align == TUI_ALIGN_EVENLY)
+  {
+    // The total height of all children combined
+    int total_h = max_size.h;
+
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      h_gap += 1;
+
+      // Account for the gap between each child window
+      total_h = MAX(0, max_size.h - (align_count - 1) * 1);
+    }
+
+    h = total_h / align_count;
+
+    // Grow first windows a little bit more to fill out extra padding
+    if (total_h - h * align_count > *align_index)
+    {
+      h += 1;
+    }
+  }
+  else if (child->h_grow)
+  {
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      h_gap += 1;
+      
+      // recalculate h_space as the extra grown height between windows
+      h_space = MAX(0, h_space - (align_count - 1) * 1); 
+    }
+
+    int gap = h_space / grow_count;
+
+    h += gap;
+
+    // Grow first windows a little bit more to fill out extra padding
+    if (h_space - gap * grow_count > *grow_index)
+    {
+      h += 1;
+    }
+
+    (*grow_index)++;
+  }
+  // If other children is grown, but not this one
+  else if (grow_count > 0)
+  {
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      h_gap += 1;
+    }
+  }
+  else if (parent->align == TUI_ALIGN_BETWEEN)
+  {
+    // Add this gap after current child
+    int gap = (float) h_space / (float) (align_count - 1);
+
+    h_gap += gap;
+
+    // Add extra gap between first windows
+    if (h_space - gap * (align_count - 1) > *align_index)
+    {
+      h_gap += 1;
+    }
+  }
+  else if (parent->align == TUI_ALIGN_AROUND)
+  {
+    // Add this gap before current child
+    int gap = (float) h_space / (float) (align_count + 1);
+
+    int rest = h_space - gap * (align_count + 1);
+
+    if (*align_index == 0 && rest > 0)
+    {
+      rect->y += (float) rest / 2.f;
+    }
+
+    rect->y += gap;
+  }
+  else if (parent->align < 3) // START, CENTER, END
+  {
+    if (*align_index == 0) // First child to align
+    {
+      // Add this gap before current child
+      if (parent->has_gap)
+      {
+        h_space = MAX(0, h_space - (align_count - 1) * 1); 
+      }
+
+      rect->y += (float) parent->align / 2.f * h_space;
+    }
+
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      h_gap += 1;
+    }
+  }
+
+  int w = tui_child_w_get(child, max_size.w);
+
+  // If there is no space left for child, use what space is left
+  int end_y = tui_child_y_get(parent);
+
+  if (rect->y + h > max_size.h + end_y)
+  {
+    if (child->is_atomic)
+    {
+      h = 0;
+    }
+    else
+    {
+      h = max_size.h + end_y - rect->y;
+    }
+  }
+
+  rect->w = w;
+  rect->h = h;
+
+  rect->x += (float) parent->pos / 2.f * (max_size.w - w);
+
+  (*align_index)++;
+
+  child->_rect = *rect;
+
+  rect->y += child->_rect.h + h_gap;
+}
+
+/*
+ * Calculate rect of horizontally aligned child
+ */
+static inline void tui_child_horiz_rect_calc(tui_rect_t* rect, tui_window_parent_t* parent, tui_window_t* child, tui_size_t max_size, tui_size_t align_size, int align_count, int* align_index, int grow_count, int* grow_index)
+{
+  if (*align_index == 0)
+  {
+    rect->x = tui_child_x_get(parent);
+  }
+
+  rect->y = tui_child_y_get(parent);
+
+  int w_space = (max_size.w - align_size.w);
+
+  int w = child->_calc_size.w;
+
+  int w_gap = 0;
+
+  // Make every child the same width
+  if (parent->align == TUI_ALIGN_EVENLY)
+  {
+    // The total width of all children combined
+    int total_w = max_size.w;
+
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      w_gap += 2;
+
+      // Account for the gap between each child window
+      total_w = MAX(0, max_size.w - (align_count - 1) * 2);
+    }
+
+    w = total_w / align_count;
+
+    // Grow first windows a little bit more to fill out extra padding
+    if (total_w - w * align_count > *align_index)
+    {
+      w += 1;
+    }
+  }
+  else if (child->w_grow)
+  {
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      w_gap += 2;
+
+      // Get the total available space for all children to grow
+      w_space = MAX(0, w_space - (align_count - 1) * 2); 
+    }
+
+    // Get the available space for this child to grow
+    // (all children grow by the same amount)
+    int gap = w_space / grow_count;
+
+    w += gap;
+
+    // Grow first windows a little bit more to fill out extra padding
+    if (w_space - gap * grow_count > *grow_index)
+    {
+      w += 1;
+    }
+
+    (*grow_index)++;
+  }
+  // If other children is grown, but not this one
+  else if (grow_count > 0)
+  {
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      w_gap += 2;
+    }
+  }
+  else if (parent->align == TUI_ALIGN_BETWEEN)
+  {
+    // Add this gap after current child
+    int gap = (float) w_space / (float) (align_count - 1);
+
+    w_gap += gap;
+
+    // Add extra gap between first windows
+    if (w_space - gap * (align_count - 1) > *align_index)
+    {
+      w_gap += 1;
+    }
+  }
+  else if (parent->align == TUI_ALIGN_AROUND)
+  {
+    int gap = (float) w_space / (float) (align_count + 1);
+
+    int rest = w_space - gap * (align_count + 1);
+
+    if (*align_index == 0 && rest > 0)
+    {
+      rect->x += (float) rest / 2.f;
+    }
+
+    rect->x += gap;
+  }
+  else if (parent->align < 3) // START, CENTER, END
+  {
+    if (*align_index == 0) // First child to align
+    {
+      // Add this gap before current child
+      if (parent->has_gap)
+      {
+        // Remove all space between windows 
+        // not including padding around the border
+        w_space = MAX(0, w_space - (align_count - 1) * 2); 
+      }
+
+      rect->x += (float) parent->align / 2.f * w_space;
+    }
+
+    if (parent->has_gap)
+    {
+      // Add this gap after current child
+      w_gap += 2;
+    }
+  }
+
+  int h = tui_child_h_get(child, max_size.h);
+
+  // If there is no space left for child, use what space is left
+  int end_x = tui_child_x_get(parent);
+
+  if (rect->x + w > max_size.w + end_x)
+  {
+    if (child->is_atomic)
+    {
+      w = 0;
+    }
+    else
+    {
+      w = max_size.w + end_x - rect->x;
+    }
+  }
+
+  rect->w = w;
+  rect->h = h;
+
+  rect->y += (float) parent->pos / 2.f * (max_size.h - h);
+
+  (*align_index)++;
+
+  child->_rect = *rect;
+
+  rect->x += child->_rect.w + w_gap;
+}
+
+/*
+ * Calculate rect of aligned child
+ */
+static inline void tui_child_rect_calc(tui_rect_t* rect, tui_window_parent_t* parent, tui_window_t* child, tui_size_t max_size, tui_size_t align_size, int align_count, int* align_index, int grow_count, int* grow_index)
+{
+  if (parent->is_vertical)
+  {
+    tui_child_vert_rect_calc(rect, parent, child, max_size, align_size, align_count, align_index, grow_count, grow_index);
+  }
+  else
+  {
+    tui_child_horiz_rect_calc(rect, parent, child, max_size, align_size, align_count, align_index, grow_count, grow_index);
+  }
+}
+
+/*
+ * Check if window can share the cells of the screen, in composite mode
+ *
+ * A WINDOW* sharing the cells of the screen can't go outside of it,
+ * so a window that is not inside the screen, and the windows in it,
+ * are drawn into WINDOWs of their own and copied onto what is under them
+ */
+static inline bool tui_window_is_shared(tui_window_t* window)
+{
+  tui_rect_t rect = window->_rect;
+
+  if (window->parent && !window->parent->head._is_shared)
+  {
+    return false;
+  }
+
+  return (rect.x >= 0 && rect.x + rect.w <= window->tui->size.w &&
+          rect.y >= 0 && rect.y + rect.h <= window->tui->size.h);
+}
+
+/*
+ * Update ncurses WINDOW* of window to its calculated rect
+ *
+ * If the rect changed, the window and its ancestors are dirty
+ */
+static inline void tui_window_ncurses_update(tui_window_t* window)
+{
+  WINDOW*    ncurses = window->window;
+  tui_rect_t rect    = window->_rect;
+
+  bool is_changed = (!ncurses ||
+      getbegx(ncurses) != rect.x || getbegy(ncurses) != rect.y ||
+      getmaxx(ncurses) != rect.w || getmaxy(ncurses) != rect.h);
+
+  if (is_changed)
+  {
+    tui_window_parents_dirty_set(window);
+  }
+
+  if (window->tui->is_composite)
+  {
+    bool is_shared = tui_window_is_shared(window);
+
+    // The children of the window share the cells of the screen, or not
+    if (is_shared != window->_is_shared && window->type == TUI_WINDOW_PARENT)
+    {
+      ((tui_window_parent_t*) window)->_layout.rect = TUI_RECT_NONE;
+    }
+
+    // A window sharing the cells of the screen is created again,
+    // because it can't be moved
+    if (is_changed || is_shared != window->_is_shared)
+    {
+      tui_window_parents_dirty_set(window);
+
+      tui_ncurses_window_free(&window->window);
+
+      window->window = is_shared ? tui_ncurses_subwindow_create(rect) : tui_ncurses_window_create(rect);
+    }
+
+    window->_is_shared = (window->window && is_shared);
+  }
+  else if (ncurses)
+  {
+    window->window = tui_ncurses_window_resize(ncurses, rect);
+  }
+  else
+  {
+    // The WINDOW* is only allocated when the window is visable
+    window->window = tui_ncurses_window_get(window->tui, rect);
+  }
+}
+
+/*
+ * Get rect for window from rect with potential negative values
+ */
+static inline tui_rect_t tui_window_rect_get(tui_rect_t rect, int parent_w, int parent_h)
+{
+  if (rect.h <= 0)
+  {
+    rect.h = MAX(0, parent_h + rect.h);
+  }
+
+  if (rect.w <= 0)
+  {
+    rect.w = MAX(0, parent_w + rect.w);
+  }
+
+  if (rect.x < 0)
+  {
+    rect.x = MAX(0, parent_w + rect.x);
+  }
+
+  if (rect.y < 0)
+  {
+    rect.y = MAX(0, parent_h + rect.y);
+  }
+
+  return rect;
+}
+
+/*
+ * Hide window by setting _is_visable to false
+ *
+ * If window is parent, hide children recursivly
+ */
+static inline void tui_window_set_invisable(tui_window_t* window)
+{
+  if (window)
+  {
+    tui_window_visable_set(window, false);
+
+    // The ncurses WINDOW* can be reused by a visable window
+    tui_ncurses_window_release(window->tui, &window->window);
+
+    window->_is_shared = false;
+
+    // The size of the window has already been calculated
+    window->_is_layout_dirty = false;
+
+    if (window->type == TUI_WINDOW_PARENT)
+    {
+      tui_window_parent_t* parent = (tui_window_parent_t*) window;
+
+      // Calculate rects of children when window is visable again
+      parent->_layout.rect = TUI_RECT_NONE;
+
+      for (size_t index = 0; index < parent->child_count; index++)
+      {
+        tui_window_t* child = parent->children[index];
+
+        tui_window_set_invisable(child);
+      }
+    }
+  }
+}
+
+/*
+ * Get maximum content size of parent
+ */
+static inline tui_size_t tui_max_size_get(tui_window_parent_t* parent)
+{
+  tui_size_t max_size =
+  {
+    .w = parent->head._rect.w,
+    .h = parent->head._rect.h
+  };
+
+  if (parent->has_padding)
+  {
+    max_size.w -= 4;
+    max_size.h -= 2;
+  }
+
+  if (parent->border.is_active)
+  {
+    max_size.w -= 2;
+    max_size.h -= 2;
+  }
+
+  if (parent->has_shadow)
+  {
+    max_size.w -= 2;
+    max_size.h -= 1;
+  }
+
+  return max_size;
+}
+
+/*
+ * Check if two layouts are equal
+ */
+static inline bool tui_layout_is_equal(tui_layout_t a, tui_layout_t b)
+{
+  return tui_rect_is_equal(a.rect, b.rect) &&
+         a.max_size.w   == b.max_size.w   && a.max_size.h   == b.max_size.h   &&
+         a.align_size.w == b.align_size.w && a.align_size.h == b.align_size.h &&
+         a.align_count  == b.align_count  && a.grow_count   == b.grow_count   &&
+         a.is_vertical  == b.is_vertical  && a.has_padding  == b.has_padding  &&
+         a.has_border   == b.has_border   && a.has_gap      == b.has_gap      &&
+         a.pos          == b.pos          && a.align        == b.align;
+}
+
+/*
+ * Get layout of parent, that the rects of its children are calculated from
+ *
+ * Children aligned at the start, that don't grow, don't depend on the
+ * combined size and amount of children, so they are left out
+ */
+static inline tui_layout_t tui_layout_get(tui_window_parent_t* parent, tui_size_t max_size, tui_size_t align_size, int align_count, int grow_count)
+{
+  bool is_used = (parent->align != TUI_ALIGN_START || grow_count > 0);
+
+  return (tui_layout_t)
+  {
+    .rect        = parent->head._rect,
+    .max_size    = max_size,
+    .align_size  = is_used ? align_size : TUI_SIZE_NONE,
+    .align_count = is_used ? align_count : 0,
+    .grow_count  = grow_count,
+    .is_vertical = parent->is_vertical,
+    .has_padding = parent->has_padding,
+    .has_border  = parent->border.is_active,
+    .has_gap     = parent->has_gap,
+    .pos         = parent->pos,
+    .align       = parent->align
+  };
+}
+
+/*
+ * Check if aligned child grows, and increments the grow index
+ */
+static inline bool tui_child_is_grown(tui_window_parent_t* parent, tui_window_t* child)
+{
+  if (parent->align == TUI_ALIGN_EVENLY) return false;
+
+  return parent->is_vertical ? child->h_grow : child->w_grow;
+}
+
+/*
+ * Calculate rect of parent's children
+ *
+ * Make use of the temporarily stored sizes in _calc_size
+ *
+ * The children are measured in one pass, where the combined size of
+ * the aligned children is summed, and arranged in a second pass.
+ * If the parent has the same layout as before, the aligned children
+ * that have not changed keep their rects, as long as every child
+ * before them ends where it did before
+ */
+static inline void tui_children_rect_calc(tui_window_parent_t* parent)
+{
+  tui_window_t* head = &parent->head;
+
+  // If nothing has changed, the children still have their calculated rects
+  if (!head->_is_layout_dirty && tui_rect_is_equal(parent->_layout.rect, head->_rect))
+  {
+    return;
+  }
+
+  head->_is_layout_dirty = false;
+
+  tui_size_t max_size = tui_max_size_get(parent);
+
+  tui_size_t align_size = { 0 };
+
+  size_t align_count = 0;
+  size_t grow_count  = 0;
+
+  // Temporary visability of children, before their rects are calculated
+  bool is_visables[MAX(1, parent->child_count)];
+
+  for (size_t index = 0; index < parent->child_count; index++)
+  {
+    tui_window_t* child = parent->children[index];
+
+    bool* is_visable = &is_visables[index];
+
+    if (!child->rect.is_none)
+    {
+      *is_visable = !child->is_hidden;
+
+      continue;
+    }
+
+    if (child->is_hidden)
+    {
+      *is_visable = false;
+    }
+    else if (parent->is_vertical)
+    {
+      if (child->is_atomic &&
+         (align_size.h + child->_calc_size.h > max_size.h ||
+          child->_calc_size.w > max_size.w))
+      {
+        *is_visable = false;
+
+        continue;
+      }
+
+      *is_visable = true;
+
+      align_count++;
+
+      align_size.h += child->_calc_size.h;
+
+      align_size.w = MAX(align_size.w, child->_calc_size.w);
+
+      if (child->h_grow)
+      {
+        grow_count++;
+      }
+    }
+    else
+    {
+      if (child->is_atomic &&
+         (align_size.w + child->_calc_size.w > max_size.w ||
+          child->_calc_size.h > max_size.h))
+      {
+        *is_visable = false;
+
+        continue;
+      }
+
+      *is_visable = true;
+
+      align_count++;
+
+      align_size.w += child->_calc_size.w;
+
+      align_size.h = MAX(align_size.h, child->_calc_size.h);
+
+      if (child->w_grow)
+      {
+        grow_count++;
+      }
+    }
+  }
+
+  align_size.w = MIN(align_size.w, max_size.w);
+  align_size.h = MIN(align_size.h, max_size.h);
+
+  tui_layout_t layout = tui_layout_get(parent, max_size, align_size, align_count, grow_count);
+
+  // The same aligned children are visable, at the same indexes
+  bool is_index_same = tui_layout_is_equal(layout, parent->_layout);
+
+  // The next aligned child starts where it did before
+  bool is_same = is_index_same;
+
+  parent->_layout = layout;
+
+  // x and y is stored temporarily for children
+  tui_rect_t rect = { 0 };
+
+  int align_index = 0;
+  int grow_index  = 0;
+
+  for (size_t index = 0; index < parent->child_count; index++)
+  {
+    tui_window_t* child = parent->children[index];
+
+    if (!is_visables[index])
+    {
+      // The aligned children after a hidden aligned child move,
+      // even if the child was invisable, because it had no size
+      if (child->_is_aligned)
+      {
+        is_index_same = false;
+
+        is_same = false;
+      }
+
+      child->_is_aligned = false;
+
+      tui_window_set_invisable(child);
+
+      continue;
+    }
+
+    if (child->rect.is_none)
+    {
+      // The child has the same rect, if it has not changed and starts where it did before
+      if (is_same && child->_is_visable && !child->_is_layout_dirty &&
+          child->_layout_size.w == child->_calc_size.w &&
+          child->_layout_size.h == child->_calc_size.h)
+      {
+        rect = child->_layout_next;
+
+        align_index++;
+
+        if (tui_child_is_grown(parent, child))
+        {
+          grow_index++;
+        }
+
+        if (child->type == TUI_WINDOW_PARENT)
+        {
+          tui_children_rect_calc((tui_window_parent_t*) child);
+        }
+        else
+        {
+          child->_is_layout_dirty = false;
+        }
+
+        continue;
+      }
+
+      // The aligned children after a shown aligned child move
+      if (!child->_is_aligned)
+      {
+        is_index_same = false;
+      }
+
+      tui_child_rect_calc(&rect, parent, child, max_size, align_size, align_count, &align_index, grow_count, &grow_index);
+
+      // If the child ends where it did before, the next child is the same
+      is_same = is_index_same && tui_rect_is_equal(rect, child->_layout_next);
+
+      child->_layout_size = child->_calc_size;
+      child->_layout_next = rect;
+      child->_is_aligned  = true;
+    }
+    else
+    {
+      // The aligned children after a child that was aligned move
+      if (child->_is_aligned)
+      {
+        is_index_same = false;
+
+        is_same = false;
+      }
+
+      child->_layout_next = TUI_RECT_NONE;
+      child->_is_aligned  = false;
+
+      tui_rect_t parent_rect = parent->head._rect;
+
+      if (parent->has_shadow)
+      {
+        parent_rect.w -= 2;
+        parent_rect.h -= 1;
+      }
+
+      child->_rect = tui_window_rect_get(child->rect, parent_rect.w, parent_rect.h);
+    }
+
+    if (child->_rect.w == 0 || child->_rect.h == 0)
+    {
+      tui_window_set_invisable(child);
+    }
+    else
+    {
+      tui_window_visable_set(child, true);
+
+      // Move child window into parent window
+      child->_rect.x += parent->head._rect.x;
+      child->_rect.y += parent->head._rect.y;
+
+      tui_window_ncurses_update(child);
+
+      if (child->type == TUI_WINDOW_PARENT)
+      {
+        tui_children_rect_calc((tui_window_parent_t*) child);
+      }
+      else
+      {
+        child->_is_layout_dirty = false;
+      }
+    }
+  }
+}
+
+/*
+ * Calculate rect of window
+ *
+ * The content of this function is similar to
+ * the content of the for loop in tui_children_rect_calc
+ */
+static inline void tui_window_rect_calc(tui_window_t* window, int w, int h)
+{
+  if (window->is_hidden)
+  {
+    tui_window_set_invisable(window);
+
+    return;
+  }
+
+  if (!window->rect.is_none)
+  {
+    window->_rect = tui_window_rect_get(window->rect, w, h);
+  }
+  else
+  {
+    window->_rect = (tui_rect_t)
+    {
+      .w = window->_calc_size.w,
+      .h = window->_calc_size.h
+    };
+  }
+
+  if (window->_rect.w == 0 || window->_rect.h == 0)
+  {
+    tui_window_set_invisable(window);
+  }
+  else
+  {
+    tui_window_visable_set(window, true);
+
+    tui_window_ncurses_update(window);
+
+    if(window->type == TUI_WINDOW_PARENT)
+    {
+      tui_children_rect_calc((tui_window_parent_t*) window);
+    }
+    else
+    {
+      window->_is_layout_dirty = false;
+    }
+  }
+}
+
+/*
+ * Calculate rects of windows
+ */
+static inline void tui_windows_rect_calc(tui_window_t** windows, size_t count, int w, int h)
+{
+  for (size_t index = 0; index < count; index++)
+  {
+    tui_window_rect_calc(windows[index], w, h);
+  }
+}
+
+/*
+ * Calculate rect of every tui window
+ *
+ * tui base windows must have fixed rect (for now)
+ */
+static inline void tui_rect_calc(tui_t* tui)
+{
+  int w = tui->size.w;
+  int h = tui->size.h;
+
+  tui_windows_rect_calc(tui->windows, tui->window_count, w, h);
+
+  tui_menu_t* menu = tui->menu;
+
+  if (menu)
+  {
+    tui_windows_rect_calc(menu->windows, menu->window_count, w, h);
+  }
+}
+
+/*
+ * Calculate sizes of tui windows and menu windows
+ */
+static inline void tui_size_calc(tui_t* tui)
+{
+  tui_windows_size_calc(tui->windows, tui->window_count);
+
+  tui_menu_t* menu = tui->menu;
+
+  if (menu)
+  {
+    tui_windows_size_calc(menu->windows, menu->window_count);
+  }
+}
+
+/*
+ * Resize tui by recalculating every size and rect of windows
+ */
+static inline void tui_resize(tui_t* tui)
+{
+  tui_size_t size =
+  {
+    .w = getmaxx(stdscr),
+    .h = getmaxy(stdscr)
+  };
+
+  // If the terminal was resized, everything has to render again
+  if (size.w != tui->size.w || size.h != tui->size.h)
+  {
+    tui->size = size;
+
+    // The terminal may have moved or cleared what it showed
+    tui->_is_front_valid = false;
+
+    tui_dirty_set(tui);
+
+    tui_layout_dirty_set(tui);
+  }
+
+  // If nothing has changed, every window still has its calculated rect
+  if (tui->_layout_calc == tui->_layout_gen) return;
+
+  TUI_STATS_TIME(size_time, tui_size_calc(tui));
+
+  TUI_STATS_TIME(rect_time, tui_rect_calc(tui));
+
+  tui->_layout_calc = tui->_layout_gen;
+}
+
+/*
+ * Update (change content) all windows and children in array
+ */
+static inline void tui_windows_update(tui_window_t** windows, size_t count)
+{
+  for (size_t index = 0; index < count; index++)
+  {
+    tui_window_t* window = windows[index];
+
+    if (window && window->event.update)
+    {
+      window->event.update(window);
+    }
+
+    if (window)
+    {
+      tui_window_layout_check(window);
+
+      tui_window_color_check(window);
+    }
+
+    // The render event can make visual changes to the window
+    if (window && window->event.render)
+    {
+      tui_window_tree_dirty_set(window);
+    }
+
+    if (window && window->type == TUI_WINDOW_PARENT)
+    {
+      tui_window_parent_t* parent = (tui_window_parent_t*) window;
+
+      tui_windows_update(parent->children, parent->child_count);
+    }
+  }
+}
+
+/*
+ * Update (change content) all tui windows and children
+ */
+static inline void tui_update(tui_t* tui)
+{
+  tui_color_check(tui);
+
+  tui_windows_update(tui->windows, tui->window_count);
+
+  tui_menu_t* menu = tui->menu;
+
+  if (menu)
+  {
+    tui_windows_update(menu->windows, menu->window_count);
+  }
+}
+
+/*
+ * Get rects of windows that are covered by their background
+ *
+ * The windows are in the order they are rendered, from the bottom window.
+ * A clean window is copied with what was under it last time,
+ * so a window over a window under it is left out, to keep what is under that window filled
+ *
+ * The rects are stored in rects, and the number of rects is returned
+ */
+static inline size_t tui_windows_opaque_rects_get(tui_rect_t* rects, tui_window_t** windows, size_t count)
+{
+  size_t rect_count = 0;
+
+  for (size_t index = 0; index < count; index++)
+  {
+    tui_window_t* window = windows[index];
+
+    if (!window->_is_visable || !window->window ||
+        window->color.bg == TUI_COLOR_NONE)
+    {
+      continue;
+    }
+
+    tui_rect_t rect = window->_rect;
+
+    // The shadow of parent window doesn't cover its corners
+    if (window->type == TUI_WINDOW_PARENT &&
+        ((tui_window_parent_t*) window)->has_shadow)
+    {
+      rect.w -= 2;
+      rect.h -= 1;
+    }
+
+    bool is_over = false;
+
+    for (size_t under = 0; under < index && !is_over; under++)
+    {
+      tui_window_t* other = windows[under];
+
+      is_over = (other->_is_visable && other->window &&
+          !tui_rect_intersect_get(other->_rect, rect).is_none);
+    }
+
+    if (rect.w > 0 && rect.h > 0 && !is_over)
+    {
+      rects[rect_count++] = rect;
+    }
+  }
+
+  return rect_count;
+}
+
+/*
+ * Fill the parts of rect on the screen that are not covered by windows
+ *
+ * Windows with a background draw over the screen anyway,
+ * so only the rows between them are filled
+ */
+static inline void tui_screen_fill(tui_t* tui, tui_rect_t rect)
+{
+  rect = tui_rect_intersect_get(rect, (tui_rect_t)
+  {
+    .w = getmaxx(stdscr),
+    .h = getmaxy(stdscr)
+  });
+
+  if (rect.is_none) return;
+
+
+  tui_menu_t* menu = tui->menu;
+
+  size_t count = tui->window_count + (menu ? menu->window_count : 0);
+
+  // The windows in the order they are rendered
+  tui_window_t* windows[MAX(1, count)];
+
+  size_t window_count = 0;
+
+  for (size_t index = tui->window_count; index-- > 0;)
+  {
+    windows[window_count++] = tui->windows[index];
+  }
+
+  for (size_t index = (menu ? menu->window_count : 0); index-- > 0;)
+  {
+    windows[window_count++] = menu->windows[index];
+  }
+
+  tui_rect_t rects[MAX(1, count)];
+
+  size_t rect_count = tui_windows_opaque_rects_get(rects, windows, window_count);
+
+  int w = rect.x + rect.w;
+  int h = rect.y + rect.h;
+
+  for (int y = rect.y; y < h; y++)
+  {
+    int x = rect.x;
+
+    while (x < w)
+    {
+      // Find where the covered part at x ends,
+      // or where the next covered part starts
+      int end  = x;
+      int next = w;
+
+      for (size_t index = 0; index < rect_count; index++)
+      {
+        tui_rect_t opaque = rects[index];
+
+        if (y < opaque.y || y >= opaque.y + opaque.h) continue;
+
+        if (opaque.x <= x && opaque.x + opaque.w > end)
+        {
+          end = opaque.x + opaque.w;
+        }
+        else if (opaque.x > x && opaque.x < next)
+        {
+          next = opaque.x;
+        }
+      }
+
+      if (end > x)
+      {
+        x = end;
+      }
+      else
+      {
+        TUI_DRAW(mvwhline(stdscr, y, x, ' ', next - x));
+
+        x = next;
+      }
+    }
+  }
+}
+
+#ifdef TUI_PROFILE
+
+/*
+ * Draw stats of the last frame in the top right corner of the screen
+ */
+static inline void tui_stats_draw(tui_t* tui)
+{
+  tui_stats_t stats = tui->stats;
+
+  char* name = (stats.slow_window && stats.slow_window->name) ? stats.slow_window->name : "-";
+
+  char lines[12][32];
+
+  snprintf(lines[0],  32, " update  %8ld us ", (long) stats.update_time);
+  snprintf(lines[1],  32, " size    %8ld us ", (long) stats.size_time);
+  snprintf(lines[2],  32, " rect    %8ld us ", (long) stats.rect_time);
+  snprintf(lines[3],  32, " render  %8ld us ", (long) stats.render_time);
+  snprintf(lines[4],  32, " present %8ld us ", (long) stats.present_time);
+  snprintf(lines[5],  32, " draws   %8zu    ", stats.draw_count);
+  snprintf(lines[6],  32, " copies  %8zu    ", stats.copy_count);
+  snprintf(lines[7],  32, " pairs   %8zu    ", stats.pair_count);
+  snprintf(lines[8],  32, " allocs  %8zu    ", stats.alloc_count);
+  snprintf(lines[9],  32, " windows %8zu    ", stats.window_count);
+  snprintf(lines[10], 32, " slowest %-11.11s ", name);
+  snprintf(lines[11], 32, "         %8ld us ", (long) stats.slow_time);
+
+  int w = strlen(lines[0]);
+
+  int x = MAX(0, tui->size.w - w);
+
+  tui_ncurses_window_color_on(stdscr, (tui_color_t)
+  {
+    .fg = TUI_COLOR_WHITE,
+    .bg = TUI_COLOR_BLACK
+  });
+
+  for (int y = 0; y < 12 && y < tui->size.h; y++)
+  {
+    TUI_DRAW(mvwaddnstr(stdscr, y, x, lines[y], tui->size.w - x));
+  }
+}
+
+/*
+ * Show or hide stats of the last frame on top of everything
+ */
+void tui_stats_show(tui_t* tui, bool is_shown)
+{
+  tui->is_stats_shown = is_shown;
+
+  // The stats are drawn over the cells of the windows
+  tui->_is_damaged = true;
+
+  tui->_is_dirty = true;
+}
+
+/*
+ * Reset stats, so the next frame only counts what happens from now on
+ */
+void tui_stats_reset(tui_t* tui)
+{
+  tui->stats = (tui_stats_t) { 0 };
+
+  frame_stats = (tui_stats_t) { 0 };
+}
+
+#endif // TUI_PROFILE
+
+/*
+ * Add the parts of the screen that windows change to damage
+ *
+ * A window changes what it covered last time and what it covers now,
+ * if it is dirty or over damage. Like when rendering, a hidden window
+ * changes what it covered last time, and a window outside the screen is not drawn
+ *
+ * If damage has grown, is_grown is set to true
+ */
+static inline void tui_windows_damage_add(tui_window_t** windows, size_t count, tui_rect_t parent_clip, tui_rect_t* damage, bool* is_grown)
+{
+  for (size_t index = 0; index < count; index++)
+  {
+    tui_window_t* window = windows[index];
+
+    tui_rect_t last_damage = *damage;
+
+    tui_rect_t clip = tui_rect_intersect_get(window->_rect, parent_clip);
+
+    if (!window->_is_visable || clip.is_none || !window->window)
+    {
+      *damage = tui_rect_union_get(*damage, window->_clip);
+    }
+    else if (window->_is_dirty ||
+        !tui_rect_intersect_get(tui_rect_union_get(window->_clip, clip), *damage).is_none)
+    {
+      *damage = tui_rect_union_get(*damage, tui_rect_union_get(window->_clip, clip));
+    }
+
+    if (!tui_rect_is_equal(*damage, last_damage))
+    {
+      *is_grown = true;
+    }
+
+    if (window->_is_visable && !clip.is_none && window->window &&
+        window->type == TUI_WINDOW_PARENT)
+    {
+      tui_window_parent_t* parent = (tui_window_parent_t*) window;
+
+      tui_windows_damage_add(parent->children, parent->child_count, clip, damage, is_grown);
+    }
+  }
+}
+
+/*
+ * Get the part of the screen that is rendered again, in composite mode
+ *
+ * A window sharing the cells of the screen draws over what is under it,
+ * and what it drew is gone when it is drawn over. So every window over
+ * the part of the screen that changes is rendered again, including the windows
+ * under it, and the part that it covers changes too, until the part stops growing
+ */
+static inline tui_rect_t tui_screen_damage_get(tui_t* tui)
+{
+  tui_rect_t screen_rect = (tui_rect_t)
+  {
+    .w = tui->size.w,
+    .h = tui->size.h
+  };
+
+  if (tui->_is_damaged) return screen_rect;
+
+  tui_menu_t* menu = tui->menu;
+
+  tui_rect_t damage = TUI_RECT_NONE;
+
+  bool is_grown = true;
+
+  while (is_grown)
+  {
+    is_grown = false;
+
+    tui_windows_damage_add(tui->windows, tui->window_count, screen_rect, &damage, &is_grown);
+
+    if (menu)
+    {
+      tui_windows_damage_add(menu->windows, menu->window_count, screen_rect, &damage, &is_grown);
+    }
+  }
+
+  return damage;
+}
+
+/*
+ * Render active menu and all windows to the screen
+ */
+static inline void tui_screen_render(tui_t* tui)
+{
+  // Color pairs used from now on belong to this frame
+  pair_frame = pair_use;
+
+  // The cursor is only sat when the active window is rendered
+  if (!tui->window || tui->window->_is_dirty)
+  {
+    tui->cursor.is_active = false;
+  }
+
+  // The output sets the cursor itself
+  if (!tui->output)
+  {
+    curs_set(0);
+  }
+
+  tui_menu_t* menu = tui->menu;
+
+  if (menu)
+  {
+    tui_ncurses_window_color_on(stdscr, menu->_color);
+  }
+  else
+  {
+    tui_ncurses_window_color_on(stdscr, tui->color);
+  }
+
+  // The parts of the screen that changed under the windows
+  tui_rect_t damage = TUI_RECT_NONE;
+
+  // In composite mode, only the part of the screen that is rendered again is filled,
+  // because the fill would draw over the cells of clean windows
+  if (tui->is_composite)
+  {
+    damage = tui_screen_damage_get(tui);
+
+    tui_screen_fill(tui, damage);
+  }
+  else
+  {
+    tui_screen_fill(tui, (tui_rect_t) { .w = tui->size.w, .h = tui->size.h });
+  }
+
+  tui->_is_damaged = false;
+
+  // 3. Render tui windows
+  tui_windows_render(tui->windows, tui->window_count, &damage);
+
+  // 4. Render menu windows
+  if (menu)
+  {
+    tui_windows_render(menu->windows, menu->window_count, &damage);
+  }
+
+#ifdef TUI_PROFILE
+  if (tui->is_stats_shown)
+  {
+    tui_stats_draw(tui);
+  }
+#endif // TUI_PROFILE
+
+  // Windows sharing the cells of the screen don't mark the screen as changed
+  if (tui->is_composite)
+  {
+    touchwin(stdscr);
+  }
+
+  tui->_is_dirty = false;
+
+  tui->_is_shown = false;
+
+  tui_cursor_t cursor = tui->cursor;
+
+  if (cursor.is_active && !tui->output)
+  {
+    if (cursor.y >= 0 && cursor.y < tui->size.h &&
+        cursor.x >= 0 && cursor.x < tui->size.w)
+    {
+      move(cursor.y, cursor.x);
+
+      curs_set(1);
+    }
+  }
+}
+
+static inline void tui_commands_apply(tui_t* tui);
+
+/*
+ * Render tui - active menu and all windows
+ */
+void tui_render(tui_t* tui)
+{
+  // Apply the commands queued from other threads
+  TUI_STATS_TIME(update_time, tui_commands_apply(tui));
+
+  TUI_STATS_TIME(update_time, tui_update(tui));
+
+  tui_resize(tui);
+
+  // If no shown window is dirty, the screen is already up to date
+  if (!tui->_is_dirty) return;
+
+  pair_evicted = false;
+
+  TUI_STATS_TIME(render_time, tui_screen_render(tui));
+
+  // If a color pair was reused, cells rendered with the old pair
+  // have changed color, so everything is rendered again, until no pair is reused.
+  // If a frame uses more colors than there are pairs, it stops after a few passes
+  for (int pass = 1; pair_evicted && pass < TUI_RENDER_PASSES; pass++)
+  {
+    pair_evicted = false;
+
+    tui_dirty_set(tui);
+
+    TUI_STATS_TIME(render_time, tui_screen_render(tui));
+  }
+
+  pair_evicted = false;
+
+#ifdef TUI_PROFILE
+  tui->stats = frame_stats;
+
+  frame_stats = (tui_stats_t) { 0 };
+#endif // TUI_PROFILE
+}
+
+/*
+ * Show rendered screen with ncurses
+ *
+ * The screen is copied with wnoutrefresh and written with one doupdate
+ */
+static inline void tui_ncurses_present(tui_t* tui)
+{
+  wnoutrefresh(stdscr);
+
+  if (tui->is_sync)
+  {
+    fputs("\033[?2026h", stdout);
+
+    fflush(stdout);
+  }
+
+  doupdate();
+
+  if (tui->is_sync)
+  {
+    fputs("\033[?2026l", stdout);
+
+    fflush(stdout);
+  }
+}
+
+// DEC line drawing letters, that ncurses draws ACS symbols with
+static const char TUI_ACS_LETTERS[] = "+,-.0`afghijklmnopqrstuvwxyz{|}~";
+
+// Unicode symbols of the DEC line drawing letters, in the same order
+static const uint32_t TUI_ACS_SYMBOLS[] =
+{
+  0x2192, 0x2190, 0x2191, 0x2193, 0x25ae, 0x25c6, 0x2592, 0x00b0,
+  0x00b1, 0x2591, 0x2603, 0x2518, 0x2510, 0x250c, 0x2514, 0x253c,
+  0x23ba, 0x23bb, 0x2500, 0x23bc, 0x23bd, 0x251c, 0x2524, 0x2534,
+  0x252c, 0x2502, 0x2264, 0x2265, 0x03c0, 0x2260, 0x00a3, 0x00b7
+};
+
+/*
+ * Get Unicode symbol of ACS symbol of the screen
+ *
+ * The screen has the character that the terminal draws the ACS symbol with,
+ * so it is looked up in acs_map
+ */
+static inline uint32_t tui_acs_symbol_get(uint32_t symbol)
+{
+  for (size_t index = 0; index < sizeof(TUI_ACS_SYMBOLS) / sizeof(uint32_t); index++)
+  {
+    if ((acs_map[(unsigned char) TUI_ACS_LETTERS[index]] & A_CHARTEXT) == symbol)
+    {
+      return TUI_ACS_SYMBOLS[index];
+    }
+  }
+
+  return symbol;
+}
+
+/*
+ * Get cells of row y of the screen
+ */
+static inline void tui_screen_row_get(tui_cell_t* cells, int y, int w)
+{
+#ifdef TUI_UTF8
+  // ncurses leaves out the second halves of wide glyphs
+  cchar_t row[MAX(1, w) + 1];
+
+  mvwin_wchnstr(stdscr, y, 0, row, w);
+#else // TUI_UTF8
+  chtype row[MAX(1, w) + 1];
+
+  mvwinchnstr(stdscr, y, 0, row, w);
+#endif // TUI_UTF8
+
+  int x = 0;
+
+  for (int index = 0; x < w; index++)
+  {
+#ifdef TUI_UTF8
+    wchar_t glyphs[CCHARW_MAX + 1] = { 0 };
+
+    attr_t attrs = 0;
+    short  pair  = 0;
+
+    getcchar(&row[index], glyphs, &attrs, &pair, NULL);
+
+    uint32_t symbol = glyphs[0];
+#else // TUI_UTF8
+    uint32_t symbol = row[index] & A_CHARTEXT;
+
+    attr_t attrs = row[index] & A_ATTRIBUTES;
+
+    short pair = PAIR_NUMBER(row[index]);
+#endif // TUI_UTF8
+
+    if (attrs & A_ALTCHARSET)
+    {
+      symbol = tui_acs_symbol_get(symbol);
+    }
+    else if (symbol == 0)
+    {
+      symbol = ' ';
+    }
+
+    cells[x] = (tui_cell_t)
+    {
+      .symbol = symbol,
+      .color  = (pair > 0 && pair < CACHE_SIZE) ? COLOR_CACHE[pair] : (tui_color_t) { 0 }
+    };
+
+#ifdef TUI_UTF8
+    // The second half of a wide glyph is covered by the glyph
+    if (tui_glyph_width_get(symbol) == 2 && x + 1 < w)
+    {
+      cells[x + 1] = (tui_cell_t)
+      {
+        .symbol = 0,
+        .color  = cells[x].color
+      };
+
+      x++;
+    }
+#endif // TUI_UTF8
+
+    x++;
+  }
+}
+
+/*
+ * Check if two cells are equal
+ */
+static inline bool tui_cell_is_equal(tui_cell_t a, tui_cell_t b)
+{
+  return a.symbol == b.symbol && tui_color_is_equal(a.color, b.color);
+}
+
+// Unchanged cells between two changed cells, that are put in the same run,
+// which is shorter than moving the cursor
+#define TUI_RUN_GAP 4
+
+/*
+ * Put run of cells with output, split into runs of the same color
+ *
+ * The color is only set when it differs from the color set last time
+ */
+static inline void tui_output_run_put(tui_output_t* output, int x, int y, tui_cell_t* cells, size_t count, tui_color_t* color, bool* has_color)
+{
+  size_t index = 0;
+
+  while (index < count)
+  {
+    size_t end = index + 1;
+
+    while (end < count && tui_color_is_equal(cells[end].color, cells[index].color))
+    {
+      end++;
+    }
+
+    if (!(*has_color) || !tui_color_is_equal(*color, cells[index].color))
+    {
+      *color = cells[index].color;
+
+      *has_color = true;
+
+      output->color_change(output, *color);
+    }
+
+    output->cells_put(output, x + index, y, cells + index, end - index);
+
+    index = end;
+  }
+}
+
+/*
+ * Show rendered screen with the output of tui
+ *
+ * The touched rows of the screen are compared with the cells
+ * the terminal shows, and only the runs of changed cells are put
+ */
+static inline void tui_output_present(tui_t* tui)
+{
+  tui_output_t* output = tui->output;
+
+  int w = tui->size.w;
+  int h = tui->size.h;
+
+  size_t count = (size_t) w * h;
+
+  if (count > tui->_front_size)
+  {
+    TUI_STATS_ADD(alloc_count, 1);
+
+    tui_cell_t* front = realloc(tui->_front, sizeof(tui_cell_t) * count);
+
+    if (!front) return;
+
+    tui->_front = front;
+
+    tui->_front_size = count;
+
+    tui->_is_front_valid = false;
+  }
+
+  // Every cell is put, if what the terminal shows is unknown
+  if (!tui->_is_front_valid)
+  {
+    for (size_t index = 0; index < count; index++)
+    {
+      tui->_front[index] = (tui_cell_t) { .symbol = UINT32_MAX };
+    }
+  }
+
+  tui_cell_t row[MAX(1, w)];
+
+  tui_color_t color = { 0 };
+
+  bool has_color = false;
+
+  for (int y = 0; y < h; y++)
+  {
+    // A row that has not been touched is the same as last time
+    if (tui->_is_front_valid && !is_linetouched(stdscr, y)) continue;
+
+    tui_screen_row_get(row, y, w);
+
+    tui_cell_t* front = tui->_front + (size_t) y * w;
+
+    int x = 0;
+
+    while (x < w)
+    {
+      if (tui_cell_is_equal(row[x], front[x]))
+      {
+        x++;
+
+        continue;
+      }
+
+      // A run neither starts nor ends in the middle of a wide glyph
+      int start = (row[x].symbol == 0 && x > 0) ? x - 1 : x;
+      int end   = x + 1;
+
+      for (int next = end; next < w && next - end < TUI_RUN_GAP; next++)
+      {
+        if (!tui_cell_is_equal(row[next], front[next]))
+        {
+          end = next + 1;
+        }
+      }
+
+      if (end < w && row[end].symbol == 0)
+      {
+        end++;
+      }
+
+      tui_output_run_put(output, start, y, row + start, end - start, &color, &has_color);
+
+      memcpy(front + start, row + start, sizeof(tui_cell_t) * (end - start));
+
+      x = end;
+    }
+  }
+
+  // Mark the rows of the screen as not touched, without writing anything,
+  // otherwise ncurses writes the screen itself when reading keys
+  wnoutrefresh(stdscr);
+
+  tui->_is_front_valid = true;
+
+  tui_cursor_t cursor = tui->cursor;
+
+  if (cursor.x < 0 || cursor.x >= w || cursor.y < 0 || cursor.y >= h)
+  {
+    cursor.is_active = false;
+  }
+
+  output->cursor_set(output, cursor);
+
+  output->flush(output, tui->is_sync);
+}
+
+/*
+ * Show rendered tui on the terminal
+ *
+ * Without an output, ncurses writes the screen. Nothing is written
+ * if nothing has been rendered since last time
+ *
+ * With is_sync, the frame is wrapped in synchronized output (DEC mode 2026),
+ * so the terminal shows the whole frame at once
+ */
+void tui_present(tui_t* tui)
+{
+  if (tui->_is_shown) return;
+
+#ifdef TUI_PROFILE
+  int64_t start = tui_time_us_get();
+#endif // TUI_PROFILE
+
+  if (tui->output)
+  {
+    tui_output_present(tui);
+  }
+  else
+  {
+    tui_ncurses_present(tui);
+  }
+
+#ifdef TUI_PROFILE
+  tui->stats.present_time = tui_time_us_get() - start;
+#endif // TUI_PROFILE
+
+  tui->_is_shown = true;
+}
+
+// RGB of tui colors in VT output, like the colors of xterm
+static const uint32_t TUI_VT_PALETTE[16] =
+{
+  0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+  0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff
+};
+
+// The buffer of VT output starts with room for the start of synchronized output
+#define TUI_VT_SYNC_START "\033[?2026h"
+#define TUI_VT_SYNC_END   "\033[?2026l"
+#define TUI_VT_SYNC_LEN   8
+
+#define TUI_VT_BUFFER_SIZE 4096
+
+/*
+ * Append string to buffer of VT output
+ */
+static inline void tui_vt_append(tui_vt_output_t* vt, const char* string, size_t length)
+{
+  if (vt->buffer_len + length > vt->buffer_size)
+  {
+    size_t size = MAX(vt->buffer_size * 2, vt->buffer_len + length);
+
+    TUI_STATS_ADD(alloc_count, 1);
+
+    char* buffer = realloc(vt->buffer, size);
+
+    if (!buffer) return;
+
+    vt->buffer = buffer;
+
+    vt->buffer_size = size;
+  }
+
+  memcpy(vt->buffer + vt->buffer_len, string, length);
+
+  vt->buffer_len += length;
+}
+
+/*
+ * Append SGR parameter of tui color to string
+ *
+ * RETURN (int length)
+ */
+static inline int tui_vt_color_print(tui_vt_output_t* vt, char* string, size_t size, short color, bool is_bg)
+{
+  if (color <= TUI_COLOR_NONE || color >= TUI_COLOR_COUNT)
+  {
+    return snprintf(string, size, is_bg ? "49" : "39");
+  }
+
+  // ncurses colors differ from tui colors by 1
+  int index = color - 1;
+
+  if (vt->is_truecolor)
+  {
+    uint32_t rgb = vt->palette[index];
+
+    return snprintf(string, size, "%d;2;%d;%d;%d", is_bg ? 48 : 38,
+      (int) (rgb >> 16) & 0xff, (int) (rgb >> 8) & 0xff, (int) rgb & 0xff);
+  }
+
+  if (index < 8)
+  {
+    return snprintf(string, size, "%d", (is_bg ? 40 : 30) + index);
+  }
+
+  return snprintf(string, size, "%d", (is_bg ? 100 : 90) + index - 8);
+}
+
+/*
+ * Move the terminal cursor of VT output, if it is not at x y
+ */
+static inline void tui_vt_cursor_move(tui_vt_output_t* vt, int x, int y)
+{
+  if (vt->_x == x && vt->_y == y) return;
+
+  char string[32];
+
+  int length = snprintf(string, sizeof(string), "\033[%d;%dH", y + 1, x + 1);
+
+  tui_vt_append(vt, string, length);
+
+  vt->_x = x;
+  vt->_y = y;
+}
+
+/*
+ * Set color of VT output, only writing the part that has changed
+ */
+static inline void tui_vt_color_change(tui_output_t* output, tui_color_t color)
+{
+  tui_vt_output_t* vt = (tui_vt_output_t*) output;
+
+  bool is_fg = !vt->_has_color || vt->_color.fg != color.fg;
+  bool is_bg = !vt->_has_color || vt->_color.bg != color.bg;
+
+  if (!is_fg && !is_bg) return;
+
+  char string[64] = "\033[";
+
+  int length = 2;
+
+  if (is_fg)
+  {
+    length += tui_vt_color_print(vt, string + length, sizeof(string) - length, color.fg, false);
+  }
+
+  if (is_fg && is_bg)
+  {
+    string[length++] = ';';
+  }
+
+  if (is_bg)
+  {
+    length += tui_vt_color_print(vt, string + length, sizeof(string) - length, color.bg, true);
+  }
+
+  string[length++] = 'm';
+
+  tui_vt_append(vt, string, length);
+
+  vt->_color = color;
+
+  vt->_has_color = true;
+}
+
+/*
+ * Get DEC line drawing letter of Unicode symbol
+ *
+ * RETURN (char letter)
+ * - 0 | The symbol is not a line drawing symbol
+ */
+static inline char tui_vt_line_get(uint32_t symbol)
+{
+  if (symbol < 0x80) return 0;
+
+  for (size_t index = 0; index < sizeof(TUI_ACS_SYMBOLS) / sizeof(uint32_t); index++)
+  {
+    if (TUI_ACS_SYMBOLS[index] == symbol)
+    {
+      return TUI_ACS_LETTERS[index];
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * Append symbol of cell to buffer of VT output
+ *
+ * With TUI_UTF8, the symbol is written as UTF-8,
+ * otherwise line symbols are written with DEC line drawing
+ */
+static inline void tui_vt_symbol_append(tui_vt_output_t* vt, uint32_t symbol)
+{
+  char string[4];
+
+#ifdef TUI_UTF8
+  if (symbol < 0x80)
+  {
+    string[0] = symbol;
+
+    tui_vt_append(vt, string, 1);
+  }
+  else if (symbol < 0x800)
+  {
+    string[0] = 0xc0 | (symbol >> 6);
+    string[1] = 0x80 | (symbol & 0x3f);
+
+    tui_vt_append(vt, string, 2);
+  }
+  else if (symbol < 0x10000)
+  {
+    string[0] = 0xe0 | (symbol >> 12);
+    string[1] = 0x80 | ((symbol >> 6) & 0x3f);
+    string[2] = 0x80 | (symbol & 0x3f);
+
+    tui_vt_append(vt, string, 3);
+  }
+  else
+  {
+    string[0] = 0xf0 | (symbol >> 18);
+    string[1] = 0x80 | ((symbol >> 12) & 0x3f);
+    string[2] = 0x80 | ((symbol >> 6) & 0x3f);
+    string[3] = 0x80 | (symbol & 0x3f);
+
+    tui_vt_append(vt, string, 4);
+  }
+#else // TUI_UTF8
+  char letter = tui_vt_line_get(symbol);
+
+  if (letter && !vt->_is_line)
+  {
+    tui_vt_append(vt, "\033(0", 3);
+
+    vt->_is_line = true;
+  }
+  else if (!letter && vt->_is_line)
+  {
+    tui_vt_append(vt, "\033(B", 3);
+
+    vt->_is_line = false;
+  }
+
+  string[0] = letter ? letter : (char) symbol;
+
+  tui_vt_append(vt, string, 1);
+#endif // TUI_UTF8
+}
+
+/*
+ * Put run of cells at x y with VT output
+ *
+ * The cursor is only moved if it is not already at x y
+ */
+static inline void tui_vt_cells_put(tui_output_t* output, int x, int y, tui_cell_t* cells, size_t count)
+{
+  tui_vt_output_t* vt = (tui_vt_output_t*) output;
+
+  tui_vt_cursor_move(vt, x, y);
+
+  for (size_t index = 0; index < count; index++)
+  {
+    // The cell is covered by the wide glyph before it
+    if (cells[index].symbol == 0) continue;
+
+    tui_vt_symbol_append(vt, cells[index].symbol);
+  }
+
+  vt->_x = x + count;
+}
+
+/*
+ * Set terminal cursor of VT output
+ */
+static inline void tui_vt_cursor_set(tui_output_t* output, tui_cursor_t cursor)
+{
+  tui_vt_output_t* vt = (tui_vt_output_t*) output;
+
+  if (cursor.is_active)
+  {
+    tui_vt_cursor_move(vt, cursor.x, cursor.y);
+
+    if (!vt->_is_shown)
+    {
+      tui_vt_append(vt, "\033[?25h", 6);
+
+      vt->_is_shown = true;
+    }
+  }
+  else if (vt->_is_shown)
+  {
+    tui_vt_append(vt, "\033[?25l", 6);
+
+    vt->_is_shown = false;
+  }
+}
+
+/*
+ * Write all of string to fd, waiting if fd is not ready
+ */
+static inline void tui_vt_write(int fd, const char* string, size_t length)
+{
+  while (length > 0)
+  {
+    ssize_t count = write(fd, string, length);
+
+    if (count < 0)
+    {
+      if (errno == EINTR) continue;
+
+      if (errno != EAGAIN && errno != EWOULDBLOCK) return;
+
+      struct pollfd pollfd = { .fd = fd, .events = POLLOUT };
+
+      poll(&pollfd, 1, -1);
+
+      continue;
+    }
+
+    string += count;
+
+    length -= count;
+  }
+}
+
+/*
+ * Write the frame of VT output with one write
+ */
+static inline void tui_vt_flush(tui_output_t* output, bool is_sync)
+{
+  tui_vt_output_t* vt = (tui_vt_output_t*) output;
+
+  // Nothing has changed
+  if (vt->buffer_len <= TUI_VT_SYNC_LEN) return;
+
+  // Other output, like ncurses at exit, expects the normal letters
+  if (vt->_is_line)
+  {
+    tui_vt_append(vt, "\033(B", 3);
+
+    vt->_is_line = false;
+  }
+
+  size_t start = TUI_VT_SYNC_LEN;
+
+  if (is_sync)
+  {
+    memcpy(vt->buffer, TUI_VT_SYNC_START, TUI_VT_SYNC_LEN);
+
+    tui_vt_append(vt, TUI_VT_SYNC_END, TUI_VT_SYNC_LEN);
+
+    start = 0;
+  }
+
+  tui_vt_write(vt->fd, vt->buffer + start, vt->buffer_len - start);
+
+  vt->buffer_len = TUI_VT_SYNC_LEN;
+}
+
+/*
+ * Configuration struct for VT output
+ */
+typedef struct tui_vt_config_t
+{
+  int   fd;           // File descriptor to write to, like STDOUT_FILENO
+  bool  is_truecolor; // Write colors as RGB of palette, instead of the 16 terminal colors
+  void* data;
+} tui_vt_config_t;
+
+/*
+ * Create VT output, that writes the screen with VT escape sequences
+ * instead of with ncurses doupdate
+ */
+tui_vt_output_t* tui_vt_output_create(tui_vt_config_t config)
+{
+  tui_vt_output_t* vt = malloc(sizeof(tui_vt_output_t));
+
+  if (!vt)
+  {
+    return NULL;
+  }
+
+  char* buffer = malloc(TUI_VT_BUFFER_SIZE);
+
+  if (!buffer)
+  {
+    free(vt);
+
+    return NULL;
+  }
+
+  *vt = (tui_vt_output_t)
+  {
+    .head =
+    {
+      .cells_put    = &tui_vt_cells_put,
+      .color_change = &tui_vt_color_change,
+      .cursor_set   = &tui_vt_cursor_set,
+      .flush        = &tui_vt_flush,
+      .data         = config.data
+    },
+    .fd           = config.fd,
+    .is_truecolor = config.is_truecolor,
+    .buffer       = buffer,
+    .buffer_size  = TUI_VT_BUFFER_SIZE,
+    .buffer_len   = TUI_VT_SYNC_LEN,
+    ._x           = -1,
+    ._y           = -1,
+    ._is_shown    = true
+  };
+
+  memcpy(vt->palette, TUI_VT_PALETTE, sizeof(vt->palette));
+
+  return vt;
+}
+
+/*
+ * Delete VT output
+ *
+ * The output has to outlive the tui that uses it
+ */
+void tui_vt_output_delete(tui_vt_output_t** output)
+{
+  if (!output || !(*output)) return;
+
+  free((*output)->buffer);
+
+  free(*output);
+
+  *output = NULL;
+}
+
+/*
+ * Configuration struct for parent window
+ */
+typedef struct tui_window_parent_config_t
+{
+  char*              name;
+  tui_window_event_t event;
+  tui_rect_t         rect;
+  bool               w_grow;
+  bool               h_grow;
+  tui_color_t        color;
+  bool               is_hidden;
+  bool               is_atomic;
+  bool               is_interact;
+  bool               is_contain;
+  tui_border_t       border;
+  bool               has_shadow;
+  bool               has_padding;
+  bool               has_gap;
+  tui_pos_t          pos;
+  tui_align_t        align;
+  bool               is_vertical;
+  void*              data;
+} tui_window_parent_config_t;
+
+/*
+ * Just create tui_window_parent_t* object
+ */
+static inline tui_window_parent_t* _tui_window_parent_create(tui_t* tui, tui_window_parent_config_t config)
+{
+  tui_window_parent_t* window = tui_arena_alloc(tui, sizeof(tui_window_parent_t));
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  memset(window, 0, sizeof(tui_window_parent_t));
+
+  tui_window_t head = (tui_window_t)
+  {
+    .type             = TUI_WINDOW_PARENT,
+    .name             = config.name,
+    .rect             = config.rect,
+    .w_grow           = config.w_grow,
+    .h_grow           = config.h_grow,
+    .is_atomic        = config.is_atomic,
+    .is_hidden        = config.is_hidden,
+    ._is_visable      = !config.is_hidden,
+    ._is_dirty        = true,
+    ._is_layout_dirty = true,
+    ._last_hidden     = config.is_hidden,
+    ._last_rect       = config.rect,
+    ._last_color      = config.color,
+    .is_interact      = config.is_interact,
+    .is_contain       = config.is_contain,
+    .color            = config.color,
+    .event            = config.event,
+    .data             = config.data,
+    .tui              = tui
+  };
+
+  *window = (tui_window_parent_t)
+  {
+    .head         = head,
+    .has_padding  = config.has_padding,
+    .has_gap      = config.has_gap,
+    .border       = config.border,
+    .has_shadow   = config.has_shadow,
+    .pos          = config.pos,
+    .align        = config.align,
+    .is_vertical  = config.is_vertical,
+    ._layout      = { .rect = TUI_RECT_NONE },
+  };
+
+  return window;
+}
+
+/*
+ * Append run of ANSI code to text window
+ */
+static inline int tui_window_text_run_append(tui_window_text_t* window, size_t index, int code)
+{
+  if (window->run_count >= window->run_size)
+  {
+    size_t run_size = MAX(8, window->run_size * 2);
+
+    TUI_STATS_ADD(alloc_count, 1);
+
+    tui_text_run_t* runs = realloc(window->runs, sizeof(tui_text_run_t) * run_size);
+
+    if (!runs)
+    {
+      return 1;
+    }
+
+    window->runs = runs;
+
+    window->run_size = run_size;
+  }
+
+  window->runs[window->run_count++] = (tui_text_run_t)
+  {
+    .index = index,
+    .code  = code
+  };
+
+  return 0;
+}
+
+/*
+ * Make room for string of length in text window
+ *
+ * The string is only allocated again if it is too small
+ */
+static inline int tui_window_text_string_alloc(tui_window_text_t* window, size_t length)
+{
+  if (length < window->string_size && window->string)
+  {
+    return 0;
+  }
+
+  free(window->string);
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  window->string = malloc(sizeof(char) * (length + 1));
+
+  window->string_size = window->string ? length + 1 : 0;
+
+  return window->string ? 0 : 1;
+}
+
+/*
+ * Make room for text of length in text window
+ *
+ * The text is only allocated again if it is too small
+ */
+static inline int tui_window_text_text_alloc(tui_window_text_t* window, size_t length)
+{
+  if (length < window->text_size && window->text)
+  {
+    return 0;
+  }
+
+  free(window->text);
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  window->text = malloc(sizeof(char) * (length + 1));
+
+  window->text_size = window->text ? length + 1 : 0;
+
+  return window->text ? 0 : 1;
+}
+
+/*
+ * Parse string of text window into text and runs of ANSI codes
+ *
+ * The text is the string with the ANSI escape codes left out.
+ * Every parameter of an escape code, like "\033[1;31;44m",
+ * is stored as a run, at the index in the text where it applies
+ */
+static inline void tui_window_text_parse(tui_window_text_t* window)
+{
+  window->text_len = 0;
+
+  window->run_count = 0;
+
+  // The text is wrapped again
+  window->_wraps[0].is_valid = false;
+  window->_wraps[1].is_valid = false;
+
+  char* string = window->string;
+
+  size_t length = string ? strlen(string) : 0;
+
+  if (!string || tui_window_text_text_alloc(window, length) != 0)
+  {
+    free(window->text);
+
+    window->text = NULL;
+
+    window->text_size = 0;
+
+    return;
+  }
+
+  char* text = window->text;
+
+  size_t text_len = 0;
+
+  for (size_t index = 0; index < length; index++)
+  {
+    if (string[index] != '\033')
+    {
+      // Copy the letters until the next escape code at once
+      size_t end = tui_string_find(string, index, length, '\033');
+
+      memcpy(text + text_len, string + index, end - index);
+
+      text_len += end - index;
+
+      index = end - 1;
+
+      continue;
+    }
+
+    // Skip the escape character and '['
+    index += 2;
+
+    while (true)
+    {
+      // An empty parameter is the same as 0
+      int code = 0;
+
+      while (index < length && string[index] >= '0' && string[index] <= '9')
+      {
+        code = code * 10 + (string[index++] - '0');
+      }
+
+      // Only store the codes that are handled
+      if (code == 0 || code == 5 ||
+         (code >= 30 && code <= 37) ||
+         (code >= 40 && code <= 47))
+      {
+        tui_window_text_run_append(window, text_len, code);
+      }
+
+      if (index < length && string[index] == ';')
+      {
+        index++;
+      }
+      else
+      {
+        break;
+      }
+    }
+
+    // Skip anything that is left of the escape code
+    while (index < length && string[index] != 'm') index++;
+  }
+
+  text[text_len] = '\0';
+
+  window->text_len = text_len;
+
+#ifdef TUI_UTF8
+  tui_window_text_glyphs_update(window);
+#endif // TUI_UTF8
+}
+
+/*
+ * Set string of text window to copy of specified string
+ *
+ * The string is parsed into text and runs once, when it is set
+ *
+ * If the string changed, the window is dirty
+ */
+void tui_window_text_string_set(tui_window_text_t* window, char* string)
+{
+  if (window && string)
+  {
+    if (window->string && strcmp(window->string, string) == 0)
+    {
+      return;
+    }
+
+    tui_window_parents_dirty_set((tui_window_t*) window);
+
+    tui_window_layout_dirty_set((tui_window_t*) window);
+
+    size_t length = strlen(string);
+
+    if (tui_window_text_string_alloc(window, length) == 0)
+    {
+      strcpy(window->string, string);
+
+      window->string[length] = '\0';
+    }
+
+    tui_window_text_parse(window);
+  }
+}
+
+/*
+ * Set string of text window, that has the ANSI code of the cursor at cursor
+ *
+ * The string can't contain any other ANSI codes,
+ * so the text is extracted directly, without parsing the string
+ */
+static inline void tui_window_text_cursor_set(tui_window_text_t* window, char* string, size_t length, size_t cursor)
+{
+  // If the string is the same, the window is already up to date
+  if (window->string && strlen(window->string) == length &&
+      memcmp(window->string, string, length) == 0)
+  {
+    return;
+  }
+
+  tui_window_parents_dirty_set((tui_window_t*) window);
+
+  tui_window_layout_dirty_set((tui_window_t*) window);
+
+  window->text_len = 0;
+
+  window->run_count = 0;
+
+  // The text is wrapped again
+  window->_wraps[0].is_valid = false;
+  window->_wraps[1].is_valid = false;
+
+  size_t text_len = length - 4;
+
+  if (tui_window_text_string_alloc(window, length) != 0 ||
+      tui_window_text_text_alloc(window, text_len) != 0)
+  {
+    return;
+  }
+
+  memcpy(window->string, string, length);
+
+  window->string[length] = '\0';
+
+  // The text is the string with the cursor code left out
+  memcpy(window->text,          string,              cursor);
+  memcpy(window->text + cursor, string + cursor + 4, text_len - cursor);
+
+  window->text[text_len] = '\0';
+
+  window->text_len = text_len;
+
+#ifdef TUI_UTF8
+  tui_window_text_glyphs_update(window);
+#endif // TUI_UTF8
+
+  tui_window_text_run_append(window, cursor, 5);
+}
+
+/*
+ * Configuration struct for text window
+ */
+typedef struct tui_window_text_config_t
+{
+  char*              name;
+  tui_window_event_t event;
+  tui_rect_t         rect;
+  bool               w_grow;
+  bool               h_grow;
+  tui_color_t        color;
+  bool               is_hidden;
+  bool               is_atomic;
+  bool               is_interact;
+  bool               is_contain;
+  char*              string;
+  bool               is_secret;
+  tui_pos_t          pos;
+  tui_align_t        align;
+  void*              data;
+} tui_window_text_config_t;
+
+/*
+ * Just create tui_window_text_t* object
+ */
+static inline tui_window_text_t* _tui_window_text_create(tui_t* tui, tui_window_text_config_t config)
+{
+  tui_window_text_t* window = tui_arena_alloc(tui, sizeof(tui_window_text_t));
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  memset(window, 0, sizeof(tui_window_text_t));
+
+  tui_window_t head = (tui_window_t)
+  {
+    .type             = TUI_WINDOW_TEXT,
+    .name             = config.name,
+    .rect             = config.rect,
+    .w_grow           = config.w_grow,
+    .h_grow           = config.h_grow,
+    .is_atomic        = config.is_atomic,
+    .is_hidden        = config.is_hidden,
+    ._is_visable      = !config.is_hidden,
+    ._is_dirty        = true,
+    ._is_layout_dirty = true,
+    ._last_hidden     = config.is_hidden,
+    ._last_rect       = config.rect,
+    ._last_color      = config.color,
+    .is_interact      = config.is_interact,
+    .is_contain       = config.is_contain,
+    .color            = config.color,
+    .event            = config.event,
+    .data             = config.data,
+    .tui              = tui
+  };
+
+  *window = (tui_window_text_t)
+  {
+    .head      = head,
+    .is_secret = config.is_secret,
+    .pos       = config.pos,
+    .align     = config.align
+  };
+
+  char* string = config.string ? config.string : "";
+
+  tui_window_text_string_set(window, string);
+
+  return window;
+}
+
+/*
+ * Configuration struct for grid window
+ */
+typedef struct tui_window_grid_config_t
+{
+  char*              name;
+  tui_window_event_t event;
+  tui_rect_t         rect;
+  bool               w_grow;
+  bool               h_grow;
+  tui_color_t        color;
+  bool               is_hidden;
+  bool               is_atomic;
+  bool               is_interact;
+  bool               is_contain;
+  tui_size_t         size;
+  void*              data;
+} tui_window_grid_config_t;
+
+/*
+ * Resize grid and store size in _size
+ */
+int tui_window_grid_resize(tui_window_grid_t* window, tui_size_t size)
+{
+  if (size.w <= 0 || size.h <= 0)
+  {
+    return 1;
+  }
+
+  free(window->grid);
+
+  int square_count = size.w * size.h;
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  tui_window_grid_square_t* grid = malloc(sizeof(tui_window_grid_square_t) * square_count);
+
+  if (!grid)
+  {
+    return 2;
+  }
+
+  memset(grid, 0, sizeof(tui_window_grid_square_t) * square_count);
+
+  window->grid = grid;
+
+  window->_size = size;
+
+  window->_damage = TUI_RECT_NONE;
+
+  tui_window_parents_dirty_set((tui_window_t*) window);
+
+  tui_window_layout_dirty_set((tui_window_t*) window);
+
+  return 0;
+}
+
+/*
+ * Just create tui_window_grid_t* object
+ */
+static inline tui_window_grid_t* _tui_window_grid_create(tui_t* tui, tui_window_grid_config_t config)
+{
+  tui_window_grid_t* window = tui_arena_alloc(tui, sizeof(tui_window_grid_t));
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  memset(window, 0, sizeof(tui_window_grid_t));
+
+  tui_window_t head = (tui_window_t)
+  {
+    .type             = TUI_WINDOW_GRID,
+    .name             = config.name,
+    .rect             = config.rect,
+    .w_grow           = config.w_grow,
+    .h_grow           = config.h_grow,
+    .is_atomic        = config.is_atomic,
+    .is_hidden        = config.is_hidden,
+    ._is_visable      = !config.is_hidden,
+    ._is_dirty        = true,
+    ._is_layout_dirty = true,
+    ._last_hidden     = config.is_hidden,
+    ._last_rect       = config.rect,
+    ._last_color      = config.color,
+    .is_interact      = config.is_interact,
+    .is_contain       = config.is_contain,
+    .color            = config.color,
+    .event            = config.event,
+    .data             = config.data,
+    .tui              = tui
+  };
+
+  *window = (tui_window_grid_t)
+  {
+    .head    = head,
+    .size    = config.size,
+    ._damage = TUI_RECT_NONE,
+  };
+
+  if (tui_window_grid_resize(window, config.size) != 0)
+  {
+    tui_arena_free(tui, window);
+
+    return NULL;
+  }
+
+  return window;
+}
+
+/*
+ * Configuration struct for log window
+ *
+ * size is the size of the buffer in bytes,
+ * and line_max is the maximum number of lines
+ */
+typedef struct tui_window_log_config_t
+{
+  char*              name;
+  tui_window_event_t event;
+  tui_rect_t         rect;
+  bool               w_grow;
+  bool               h_grow;
+  tui_color_t        color;
+  bool               is_hidden;
+  bool               is_atomic;
+  bool               is_interact;
+  bool               is_contain;
+  size_t             size;
+  size_t             line_max;
+  void*              data;
+} tui_window_log_config_t;
+
+#define TUI_LOG_SIZE     65536
+#define TUI_LOG_LINE_MAX 1024
+
+/*
+ * Just create tui_window_log_t* object
+ */
+static inline tui_window_log_t* _tui_window_log_create(tui_t* tui, tui_window_log_config_t config)
+{
+  tui_window_log_t* window = tui_arena_alloc(tui, sizeof(tui_window_log_t));
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  memset(window, 0, sizeof(tui_window_log_t));
+
+  tui_window_t head = (tui_window_t)
+  {
+    .type             = TUI_WINDOW_LOG,
+    .name             = config.name,
+    .rect             = config.rect,
+    .w_grow           = config.w_grow,
+    .h_grow           = config.h_grow,
+    .is_atomic        = config.is_atomic,
+    .is_hidden        = config.is_hidden,
+    ._is_visable      = !config.is_hidden,
+    ._is_dirty        = true,
+    ._is_layout_dirty = true,
+    ._last_hidden     = config.is_hidden,
+    ._last_rect       = config.rect,
+    ._last_color      = config.color,
+    .is_interact      = config.is_interact,
+    .is_contain       = config.is_contain,
+    .color            = config.color,
+    .event            = config.event,
+    .data             = config.data,
+    .tui              = tui
+  };
+
+  size_t size     = config.size     ? config.size     : TUI_LOG_SIZE;
+  size_t line_max = config.line_max ? config.line_max : TUI_LOG_LINE_MAX;
+
+  TUI_STATS_ADD(alloc_count, 2);
+
+  *window = (tui_window_log_t)
+  {
+    .head        = head,
+    .buffer      = malloc(sizeof(char) * size),
+    .buffer_size = size,
+    .lines       = malloc(sizeof(tui_log_line_t) * line_max),
+    .line_max    = line_max
+  };
+
+  if (!window->buffer || !window->lines)
+  {
+    free(window->buffer);
+
+    free(window->lines);
+
+    tui_arena_free(tui, window);
+
+    return NULL;
+  }
+
+  return window;
+}
+
+/*
+ * Append window to array of windows
+ */
+static inline int tui_windows_window_append(tui_window_t*** windows, size_t* count, size_t* size, tui_window_t* window)
+{
+  // The array grows by doubling, so appending is amortized constant
+  if (*count >= *size)
+  {
+    size_t new_size = MAX(4, *size * 2);
+
+    TUI_STATS_ADD(alloc_count, 1);
+
+    tui_window_t** temp_windows = realloc(*windows, sizeof(tui_window_t*) * new_size);
+
+    if (!temp_windows)
+    {
+      return 1;
+    }
+
+    *windows = temp_windows;
+
+    *size = new_size;
+  }
+
+  (*windows)[*count] = window;
+
+  (*count)++;
+
+  return 0;
+}
+
+/*
+ * Append window to tui windows
+ */
+static inline int tui_window_append(tui_t* tui, tui_window_t* window)
+{
+  tui_window_parents_dirty_set(window);
+
+  tui_window_layout_dirty_set(window);
+
+  if (tui_windows_window_append(&tui->windows, &tui->window_count, &tui->window_size, window) != 0)
+  {
+    return 1;
+  }
+
+  return tui_index_window_add(&tui->_index, window);
+}
+
+/*
+ * Append window to menu windows, and store menu reference in window
+ */
+static inline int tui_menu_window_append(tui_menu_t* menu, tui_window_t* window)
+{
+  window->menu = menu;
+
+  tui_window_parents_dirty_set(window);
+
+  tui_window_layout_dirty_set(window);
+
+  if (tui_windows_window_append(&menu->windows, &menu->window_count, &menu->window_size, window) != 0)
+  {
+    return 1;
+  }
+
+  return tui_index_window_add(&menu->tui->_index, window);
+}
+
+/*
+ * Append child to parent children, and store parent and menu reference in child
+ */
+static inline int tui_parent_child_append(tui_window_parent_t* parent, tui_window_t* child)
+{
+  child->parent = parent;
+  child->menu   = parent->head.menu;
+
+  tui_window_parents_dirty_set(child);
+
+  tui_window_layout_dirty_set(child);
+
+  if (tui_windows_window_append(&parent->children, &parent->child_count, &parent->child_size, child) != 0)
+  {
+    return 1;
+  }
+
+  return tui_index_window_add(&parent->head.tui->_index, child);
+}
+
+/*
+ * Create parent window and add it to tui
+ */
+tui_window_parent_t* tui_window_parent_create(tui_t* tui, tui_window_parent_config_t config)
+{
+  tui_window_parent_t* window = _tui_window_parent_create(tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_window_append(tui, (tui_window_t*) window) != 0)
+  {
+    tui_window_parent_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create parent window and add it to menu
+ */
+tui_window_parent_t* tui_menu_window_parent_create(tui_menu_t* menu, tui_window_parent_config_t config)
+{
+  tui_window_parent_t* window = _tui_window_parent_create(menu->tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_menu_window_append(menu, (tui_window_t*) window) != 0)
+  {
+    tui_window_parent_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create parent window and add it to window as child
+ */
+tui_window_parent_t* tui_parent_child_parent_create(tui_window_parent_t* parent, tui_window_parent_config_t config)
+{
+  tui_window_parent_t* child = _tui_window_parent_create(parent->head.tui, config);
+
+  if (!child)
+  {
+    return NULL;
+  }
+
+  if (tui_parent_child_append(parent, (tui_window_t*) child) != 0)
+  {
+    tui_window_parent_free(&child);
+
+    return NULL;
+  }
+
+  if (child->head.event.init)
+  {
+    child->head.event.init((tui_window_t*) child);
+  }
+
+  return child;
+}
+
+/*
+ * Create text window and add it to tui
+ */
+tui_window_text_t* tui_window_text_create(tui_t* tui, tui_window_text_config_t config)
+{
+  tui_window_text_t* window = _tui_window_text_create(tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_window_append(tui, (tui_window_t*) window) != 0)
+  {
+    tui_window_text_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create text window and add it to menu
+ */
+tui_window_text_t* tui_menu_window_text_create(tui_menu_t* menu, tui_window_text_config_t config)
+{
+  tui_window_text_t* window = _tui_window_text_create(menu->tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_menu_window_append(menu, (tui_window_t*) window) != 0)
+  {
+    tui_window_text_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create text window and add it to window as child
+ */
+tui_window_text_t* tui_parent_child_text_create(tui_window_parent_t* parent, tui_window_text_config_t config)
+{
+  tui_window_text_t* child = _tui_window_text_create(parent->head.tui, config);
+
+  if (!child)
+  {
+    return NULL;
+  }
+
+  if (tui_parent_child_append(parent, (tui_window_t*) child) != 0)
+  {
+    tui_window_text_free(&child);
+
+    return NULL;
+  }
+
+  if (child->head.event.init)
+  {
+    child->head.event.init((tui_window_t*) child);
+  }
+
+  return child;
+}
+
+/*
+ * Create grid window and add it to tui
+ */
+tui_window_grid_t* tui_window_grid_create(tui_t* tui, tui_window_grid_config_t config)
+{
+  tui_window_grid_t* window = _tui_window_grid_create(tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_window_append(tui, (tui_window_t*) window) != 0)
+  {
+    tui_window_grid_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create grid window and add it to menu
+ */
+tui_window_grid_t* tui_menu_window_grid_create(tui_menu_t* menu, tui_window_grid_config_t config)
+{
+  tui_window_grid_t* window = _tui_window_grid_create(menu->tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_menu_window_append(menu, (tui_window_t*) window) != 0)
+  {
+    tui_window_grid_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create grid window and add it to window as child
+ */
+tui_window_grid_t* tui_parent_child_grid_create(tui_window_parent_t* parent, tui_window_grid_config_t config)
+{
+  tui_window_grid_t* child = _tui_window_grid_create(parent->head.tui, config);
+
+  if (!child)
+  {
+    return NULL;
+  }
+
+  if (tui_parent_child_append(parent, (tui_window_t*) child) != 0)
+  {
+    tui_window_grid_free(&child);
+
+    return NULL;
+  }
+
+  if (child->head.event.init)
+  {
+    child->head.event.init((tui_window_t*) child);
+  }
+
+  return child;
+}
+
+/*
+ * Create log window and add it to tui
+ */
+tui_window_log_t* tui_window_log_create(tui_t* tui, tui_window_log_config_t config)
+{
+  tui_window_log_t* window = _tui_window_log_create(tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_window_append(tui, (tui_window_t*) window) != 0)
+  {
+    tui_window_log_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create log window and add it to menu
+ */
+tui_window_log_t* tui_menu_window_log_create(tui_menu_t* menu, tui_window_log_config_t config)
+{
+  tui_window_log_t* window = _tui_window_log_create(menu->tui, config);
+
+  if (!window)
+  {
+    return NULL;
+  }
+
+  if (tui_menu_window_append(menu, (tui_window_t*) window) != 0)
+  {
+    tui_window_log_free(&window);
+
+    return NULL;
+  }
+
+  if (window->head.event.init)
+  {
+    window->head.event.init((tui_window_t*) window);
+  }
+
+  return window;
+}
+
+/*
+ * Create log window and add it to window as child
+ */
+tui_window_log_t* tui_parent_child_log_create(tui_window_parent_t* parent, tui_window_log_config_t config)
+{
+  tui_window_log_t* child = _tui_window_log_create(parent->head.tui, config);
+
+  if (!child)
+  {
+    return NULL;
+  }
+
+  if (tui_parent_child_append(parent, (tui_window_t*) child) != 0)
+  {
+    tui_window_log_free(&child);
+
+    return NULL;
+  }
+
+  if (child->head.event.init)
+  {
+    child->head.event.init((tui_window_t*) child);
+  }
+
+  return child;
+}
+
+/*
+ * Get square at x y in grid window
+ */
+tui_window_grid_square_t* tui_window_grid_square_get(tui_window_grid_t* window, int x, int y)
+{
+  if (x >= 0 && x < window->_size.w &&
+      y >= 0 && y < window->_size.h)
+  {
+    int index = y * window->_size.w + x;
+
+    return &window->grid[index];
+  }
+
+  return NULL;
+}
+
+/*
+ * Check if two grid squares are equal
+ */
+static inline bool tui_window_grid_square_is_equal(tui_window_grid_square_t a, tui_window_grid_square_t b)
+{
+  return (a.symbol   == b.symbol   &&
+          a.color.fg == b.color.fg &&
+          a.color.bg == b.color.bg);
+}
+
+/*
+ * Extend damage rect of grid window to include rect
+ *
+ * Only the ancestors are marked as dirty,
+ * the grid window itself only renders the damaged squares
+ */
+static inline void tui_window_grid_damage_add(tui_window_grid_t* window, tui_rect_t rect)
+{
+  tui_rect_t damage = window->_damage;
+
+  if (damage.is_none)
+  {
+    window->_damage = rect;
+  }
+  else
+  {
+    int x1 = MIN(damage.x, rect.x);
+    int y1 = MIN(damage.y, rect.y);
+    int x2 = MAX(damage.x + damage.w, rect.x + rect.w);
+    int y2 = MAX(damage.y + damage.h, rect.y + rect.h);
+
+    window->_damage = (tui_rect_t)
+    {
+      .x = x1,
+      .y = y1,
+      .w = x2 - x1,
+      .h = y2 - y1
+    };
+  }
+
+  bool is_dirty = window->head._is_dirty;
+
+  tui_window_parents_dirty_set((tui_window_t*) window);
+
+  window->head._is_dirty = is_dirty;
+}
+
+/*
+ * Set color and symbol of square in grid window
+ */
+void tui_window_grid_square_set(tui_window_grid_t* window, int x, int y, tui_window_grid_square_t square)
+{
+  tui_window_grid_square_t* old_square = tui_window_grid_square_get(window, x, y);
+
+  if (old_square && !tui_window_grid_square_is_equal(*old_square, square))
+  {
+    *old_square = square;
+
+    tui_window_grid_damage_add(window, (tui_rect_t)
+    {
+      .x = x,
+      .y = y,
+      .w = 1,
+      .h = 1
+    });
+  }
+}
+
+/*
+ * Set squares of grid window inside rect, from buffer of squares
+ *
+ * The buffer contains rect.w * rect.h squares, row by row
+ *
+ * Only the part of rect that is inside the grid is set
+ */
+void tui_window_grid_rect_set(tui_window_grid_t* window, tui_rect_t rect, tui_window_grid_square_t* squares)
+{
+  if (!window->grid || !squares) return;
+
+  int x1 = MAX(0, rect.x);
+  int y1 = MAX(0, rect.y);
+  int x2 = MIN(window->_size.w, rect.x + rect.w);
+  int y2 = MIN(window->_size.h, rect.y + rect.h);
+
+  // Bounds of the squares that actually changed
+  int min_x = x2, min_y = y2, max_x = x1, max_y = y1;
+
+  for (int y = y1; y < y2; y++)
+  {
+    for (int x = x1; x < x2; x++)
+    {
+      tui_window_grid_square_t square = squares[(y - rect.y) * rect.w + (x - rect.x)];
+
+      tui_window_grid_square_t* old_square = &window->grid[y * window->_size.w + x];
+
+      if (!tui_window_grid_square_is_equal(*old_square, square))
+      {
+        *old_square = square;
+
+        min_x = MIN(min_x, x);
+        min_y = MIN(min_y, y);
+        max_x = MAX(max_x, x + 1);
+        max_y = MAX(max_y, y + 1);
+      }
+    }
+  }
+
+  if (min_x < max_x && min_y < max_y)
+  {
+    tui_window_grid_damage_add(window, (tui_rect_t)
+    {
+      .x = min_x,
+      .y = min_y,
+      .w = max_x - min_x,
+      .h = max_y - min_y
+    });
+  }
+}
+
+/*
+ * Set squares of row in grid window, from buffer of squares
+ *
+ * The buffer contains as many squares as the grid is wide
+ */
+void tui_window_grid_row_set(tui_window_grid_t* window, int y, tui_window_grid_square_t* squares)
+{
+  tui_window_grid_rect_set(window, (tui_rect_t)
+  {
+    .x = 0,
+    .y = y,
+    .w = window->_size.w,
+    .h = 1
+  }, squares);
+}
+
+/*
+ * Modify grid square by changing symbol or color if specified
+ */
+void tui_window_grid_square_modify(tui_window_grid_t* window, int x, int y, tui_window_grid_square_t square)
+{
+  tui_window_grid_square_t* old_square = tui_window_grid_square_get(window, x, y);
+
+  if (old_square)
+  {
+    tui_window_grid_square_t new_square = *old_square;
+
+    if (square.color.fg != TUI_COLOR_NONE)
+    {
+      new_square.color.fg = square.color.fg;
+    }
+
+    if (square.color.bg != TUI_COLOR_NONE)
+    {
+      new_square.color.bg = square.color.bg;
+    }
+
+    if (square.symbol)
+    {
+      new_square.symbol = square.symbol;
+    }
+
+    tui_window_grid_square_set(window, x, y, new_square);
+  }
+}
+
+/*
+ * Drop the oldest line of log window
+ */
+static inline void tui_window_log_line_drop(tui_window_log_t* window)
+{
+  window->_line_start = (window->_line_start + 1) % window->line_max;
+
+  window->line_count--;
+
+  if (window->line_count == 0)
+  {
+    window->_line_start = 0;
+
+    window->_buffer_end = 0;
+  }
+}
+
+/*
+ * Add one line to log window
+ *
+ * The line is stored after the newest line, or at the start of the
+ * buffer if it doesn't fit at the end. The oldest lines in the way
+ * are dropped, so the cost doesn't depend on the number of lines
+ */
+static inline void tui_window_log_line_add(tui_window_log_t* window, char* string, size_t length)
+{
+  // Every line takes up one more byte, for the null terminator
+  length = MIN(length, window->buffer_size - 1);
+
+  size_t index = window->_buffer_end;
+
+  if (index + length + 1 > window->buffer_size)
+  {
+    // The lines at the end of the buffer are the oldest lines
+    while (window->line_count > 0 &&
+           tui_window_log_line_get(window, 0)->index >= index)
+    {
+      tui_window_log_line_drop(window);
+    }
+
+    index = 0;
+  }
+
+  // Drop the oldest lines that are in the way of the new line
+  while (window->line_count > 0)
+  {
+    tui_log_line_t* oldest = tui_window_log_line_get(window, 0);
+
+    if (oldest->index < index || oldest->index >= index + length + 1) break;
+
+    tui_window_log_line_drop(window);
+  }
+
+  if (window->line_count >= window->line_max)
+  {
+    tui_window_log_line_drop(window);
+  }
+
+  memcpy(window->buffer + index, string, length);
+
+  window->buffer[index + length] = '\0';
+
+  // The rows of the line are counted when it is rendered,
+  // the same way as it is drawn
+  window->lines[(window->_line_start + window->line_count) % window->line_max] = (tui_log_line_t)
+  {
+    .index  = index,
+    .length = length
+  };
+
+  window->line_count++;
+
+  window->_buffer_end = index + length + 1;
+}
+
+/*
+ * Append string to log window, one line for every '\n'
+ *
+ * If the log is scrolled, the same lines are kept in view
+ */
+void tui_window_log_append(tui_window_log_t* window, char* string)
+{
+  if (!window || !string) return;
+
+  size_t line_count = 0;
+
+  char* line = string;
+
+  while (true)
+  {
+    char* end = strchr(line, '\n');
+
+    size_t length = end ? (size_t) (end - line) : strlen(line);
+
+    tui_window_log_line_add(window, line, length);
+
+    line_count++;
+
+    if (!end) break;
+
+    line = end + 1;
+  }
+
+  if (window->scroll > 0)
+  {
+    window->scroll = MIN(window->scroll + line_count, window->line_count - 1);
+
+    // The lines in view has only changed if the oldest line was dropped
+    if (window->scroll < window->line_count - 1) return;
+  }
+
+  tui_window_parents_dirty_set((tui_window_t*) window);
+}
+
+/*
+ * Set number of lines log window is scrolled up from the newest line
+ */
+void tui_window_log_scroll_set(tui_window_log_t* window, size_t scroll)
+{
+  scroll = MIN(scroll, MAX(1, window->line_count) - 1);
+
+  if (window->scroll != scroll)
+  {
+    window->scroll = scroll;
+
+    tui_window_parents_dirty_set((tui_window_t*) window);
+  }
+}
+
+/*
+ * Remove all lines from log window
+ */
+void tui_window_log_clear(tui_window_log_t* window)
+{
+  window->_line_start = 0;
+  window->_buffer_end = 0;
+  window->line_count  = 0;
+  window->scroll      = 0;
+
+  tui_window_parents_dirty_set((tui_window_t*) window);
+}
+
+/*
+ * Push command to the queue of tui
+ *
+ * This is safe to call from any thread, without locking
+ *
+ * If the queue was empty, the main loop is woken up
+ */
+static inline void tui_command_push(tui_t* tui, tui_command_t* command)
+{
+  tui_command_t* head = atomic_load(&tui->_queue->stack);
+
+  do
+  {
+    command->next = head;
+  }
+  while (!atomic_compare_exchange_weak(&tui->_queue->stack, &head, command));
+
+  if (!head && tui->_wake_fds[1] != -1)
+  {
+    char byte = 0;
+
+    // If the pipe is full, the loop is already woken up
+    if (write(tui->_wake_fds[1], &byte, 1) == -1) {}
+  }
+}
+
+/*
+ * Create command and push it to the queue of window's tui
+ */
+static inline int tui_command_queue(tui_window_t* window, tui_command_t command)
+{
+  if (!window->tui->_queue)
+  {
+    free(command.data);
+
+    return 1;
+  }
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  tui_command_t* new_command = malloc(sizeof(tui_command_t));
+
+  if (!new_command)
+  {
+    free(command.data);
+
+    return 1;
+  }
+
+  *new_command = command;
+
+  new_command->window = window;
+
+  tui_command_push(window->tui, new_command);
+
+  return 0;
+}
+
+/*
+ * Queue setting string of text window, from any thread
+ *
+ * The string is copied and set right before the next render
+ */
+int tui_window_text_string_queue(tui_window_text_t* window, char* string)
+{
+  if (!window || !string) return 1;
+
+  size_t size = sizeof(char) * (strlen(string) + 1);
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  char* copy = malloc(size);
+
+  if (!copy)
+  {
+    return 2;
+  }
+
+  memcpy(copy, string, size);
+
+  return tui_command_queue((tui_window_t*) window, (tui_command_t)
+  {
+    .type = TUI_COMMAND_TEXT,
+    .data = copy
+  });
+}
+
+/*
+ * Queue setting squares inside rect of grid window, from any thread
+ *
+ * The rect.w * rect.h squares are copied and set right before the next render
+ */
+int tui_window_grid_rect_queue(tui_window_grid_t* window, tui_rect_t rect, tui_window_grid_square_t* squares)
+{
+  if (!window || !squares || rect.w <= 0 || rect.h <= 0) return 1;
+
+  size_t size = sizeof(tui_window_grid_square_t) * rect.w * rect.h;
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  tui_window_grid_square_t* copy = malloc(size);
+
+  if (!copy)
+  {
+    return 2;
+  }
+
+  memcpy(copy, squares, size);
+
+  return tui_command_queue((tui_window_t*) window, (tui_command_t)
+  {
+    .type = TUI_COMMAND_GRID,
+    .rect = rect,
+    .data = copy
+  });
+}
+
+/*
+ * Queue hiding or showing window, from any thread
+ */
+int tui_window_hidden_queue(tui_window_t* window, bool is_hidden)
+{
+  if (!window) return 1;
+
+  return tui_command_queue(window, (tui_command_t)
+  {
+    .type      = TUI_COMMAND_HIDE,
+    .is_hidden = is_hidden
+  });
+}
+
+/*
+ * Apply all queued commands, in the order they were queued
+ */
+static inline void tui_commands_apply(tui_t* tui)
+{
+  tui_queue_t* queue = tui->_queue;
+
+  if (!queue) return;
+
+  // Take all commands at once
+  tui_commands_take(queue);
+
+  tui_command_t* command = queue->list;
+
+  queue->list = NULL;
+
+  while (command)
+  {
+    switch (command->type)
+    {
+      case TUI_COMMAND_TEXT:
+        tui_window_text_string_set((tui_window_text_t*) command->window, command->data);
+        break;
+
+      case TUI_COMMAND_GRID:
+        tui_window_grid_rect_set((tui_window_grid_t*) command->window, command->rect, command->data);
+        break;
+
+      case TUI_COMMAND_HIDE:
+        command->window->is_hidden = command->is_hidden;
+        break;
+
+      default:
+        break;
+    }
+
+    tui_command_t* next = command->next;
+
+    tui_command_free(&command);
+
+    command = next;
+  }
+}
+
+/*
+ * Move gap of gap buffer to index
+ *
+ * Only the characters between the gap and index are moved
+ */
+static inline void tui_gap_move(char* buffer, size_t gap_size, size_t* gap, size_t index)
+{
+  if (index < *gap)
+  {
+    memmove(buffer + index + gap_size, buffer + index, *gap - index);
+  }
+  else if (index > *gap)
+  {
+    memmove(buffer + *gap, buffer + *gap + gap_size, index - *gap);
+  }
+
+  *gap = index;
+}
+
+/*
+ * Move gap of input buffer to index
+ */
+static inline void tui_input_gap_move(tui_input_t* input, size_t index)
+{
+  tui_gap_move(input->buffer, input->buffer_size - input->buffer_len, &input->_gap, index);
+}
+
+/*
+ * Get text of input, as a string
+ *
+ * The gap is moved to the end of the buffer, so the text is in one piece
+ */
+char* tui_input_buffer_get(tui_input_t* input)
+{
+  tui_input_gap_move(input, input->buffer_len);
+
+  input->buffer[input->buffer_len] = '\0';
+
+  return input->buffer;
+}
+
+/*
+ * Update visable string from input buffer
+ *
+ * The buffer can for example be partially visable
+ */
+static inline void tui_input_string_update(tui_input_t* input)
+{
+  size_t gap_size = input->buffer_size - input->buffer_len;
+
+  // Only the text that fits on the screen can be visable,
+  // after the cursor
+  size_t max_len = (size_t) MAX(1, input->tui->size.w * input->tui->size.h);
+
+  size_t start = input->scroll;
+
+  size_t end = MIN(input->buffer_len, start + MAX(max_len, input->cursor - start));
+
+  size_t string_len = 0;
+
+  for (size_t index = start; index < end; index++)
+  {
+    if (index == input->cursor)
+    {
+      memcpy(input->string + string_len, "\033[5m", 4);
+
+      string_len += 4;
+    }
+
+    input->string[string_len++] = input->buffer[(index < input->_gap) ? index : index + gap_size];
+  }
+
+  if (input->cursor >= end)
+  {
+    memcpy(input->string + string_len, "\033[5m", 4);
+
+    string_len += 4;
+  }
+
+  tui_window_t* window = input->tui->window;
+
+  // If the cursor is at the end of the string,
+  // and input text window is the active window,
+  // add space for cursor
+  if (input->cursor == input->buffer_len &&
+      window && (tui_window_t*) input->window == window)
+  {
+    input->string[string_len++] = ' ';
+  }
+
+  input->string[string_len] = '\0';
+
+  // The string is given to the text window directly, without parsing it
+  if (input->window)
+  {
+    tui_window_text_cursor_set(input->window, input->string, string_len, input->cursor - start);
+  }
+}
+
+/*
+ * Create input struct
+ */
+tui_input_t* tui_input_create(tui_t* tui, size_t size, tui_window_text_t* window)
+{
+  TUI_STATS_ADD(alloc_count, 1);
+
+  tui_input_t* input = malloc(sizeof(tui_input_t));
+
+  if (!input)
+  {
+    return NULL;
+  }
+
+  memset(input, 0, sizeof(tui_input_t));
+
+  *input = (tui_input_t)
+  {
+    .buffer_size = size,
+    .tui         = tui,
+    .window      = window,
+  };
+
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  input->buffer = malloc(sizeof(char) * (size + 1));
+
+  if (!input->buffer)
+  {
+    free(input);
+
+    return NULL;
+  }
+
+  memset(input->buffer, '\0', sizeof(char) * (size + 1));
+
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  input->string = malloc(sizeof(char) * (size + 6));
+
+  if (!input->string)
+  {
+    free(input->buffer);
+
+    free(input);
+
+    return NULL;
+  }
+
+  tui_input_string_update(input);
+
+  return input;
+}
+
+/*
+ * Delete input struct
+ */
+void tui_input_delete(tui_input_t** input)
+{
+  if (!input || !(*input)) return;
+
+  free((*input)->buffer);
+
+  free((*input)->string);
+
+  free(*input);
+
+  *input = NULL;
+}
+
+/*
+ * Add symbol to input buffer
+ */
+static inline bool tui_input_symbol_add(tui_input_t* input, int key)
+{
+  if (input->buffer_len >= input->buffer_size)
+  {
+    return false;
+  }
+
+  if (key < 32 || key > 126)
+  {
+    return false;
+  }
+
+  char symbol = key;
+
+  // The character is added at the start of the gap
+  tui_input_gap_move(input, input->cursor);
+
+  input->buffer[input->_gap++] = symbol;
+
+  input->buffer_len++;
+
+
+  if (input->cursor < input->buffer_len)
+  {
+    input->cursor++;
+  }
+
+  // The cursor is at the end of the input window
+  /*
+  if((win->cursor - win->scroll) >= (win->head.w - 2))
+  {
+    win->scroll++; // Scroll one more character
+  }
+  */
+
+  tui_input_string_update(input);
+
+  return true;
+}
+
+/*
+ * Delete symbol from input buffer
+ */
+static inline bool tui_input_symbol_del(tui_input_t* input)
+{
+  if (input->cursor <= 0 || input->buffer_len <= 0)
+  {
+    return false;
+  }
+
+  // The deleted character becomes part of the gap
+  tui_input_gap_move(input, input->cursor);
+
+  input->_gap--;
+
+  input->buffer_len--;
+
+  input->cursor = MIN(input->cursor - 1, input->buffer_len);
+
+  tui_input_string_update(input);
+
+  return true;
+}
+
+/*
+ * Scroll right in input buffer
+ */
+static inline bool tui_input_scroll_right(tui_input_t* input)
+{
+  // If input text window is not the active window, scrolling is disabled
+  if (!input->window || input->tui->window != (tui_window_t*) input->window)
+  {
+    return false;
+  }
+
+  // The cursor can not be further than the text itself
+  if (input->cursor >= input->buffer_len)
+  {
+    return false;
+  }
+
+  input->cursor++;
+
+  tui_input_string_update(input);
+
+  return true;
+}
+
+/*
+ * Scroll left in input buffer
+ */
+static inline bool tui_input_scroll_left(tui_input_t* input)
+{
+  // If input text window is not the active window, scrolling is disabled
+  if (!input->window || input->tui->window != (tui_window_t*) input->window)
+  {
+    return false;
+  }
+
+  // Can't scroll past the beginning
+  if (input->cursor == 0)
+  {
+    return false;
+  }
+
+  input->cursor--;
+
+  // If the cursor is to the left of the window,
+  // scroll to the start of the cursor
+  if (input->cursor < input->scroll)
+  {
+    input->scroll = input->cursor;
+  }
+
+  tui_input_string_update(input);
+
+  return true;
+}
+
+/*
+ * Handle keypress in input window
+ */
+bool tui_input_event(tui_input_t* input, int key)
+{
+  switch (key)
+  {
+    case KEY_RIGHT:
+      return tui_input_scroll_right(input);
+
+    case KEY_LEFT:
+      return tui_input_scroll_left(input);
+
+    case KEY_BACKSPACE:
+      return tui_input_symbol_del(input);
+    
+    default:
+      return tui_input_symbol_add(input, key);
   }
+
+  return false;
 }
 
 /*
- * Resize tui by recalculating every size and rect of windows
+ * Get length of line in text area, where index 0 is the first line
+ *
+ * The lines before the line of the cursor are stored before the gap,
+ * and the line of the cursor and the lines after it are stored after the gap
  */
-static inline void tui_resize(tui_t* tui)
+static inline size_t* tui_textarea_line_get(tui_textarea_t* textarea, size_t index)
 {
-  tui->size.w = getmaxx(stdscr);
-  tui->size.h = getmaxy(stdscr);
-
-  tui_size_calc(tui);
+  if (index >= textarea->line)
+  {
+    index += textarea->line_size - textarea->line_count;
+  }
 
-  tui_rect_calc(tui);
+  return &textarea->lines[index];
 }
 
 /*
- * Update (change content) all windows and children in array
+ * Make room for one more character and one more line in text area
+ *
+ * The text and the lines after the gaps are moved to the end
  */
-static inline void tui_windows_update(tui_window_t** windows, size_t count)
+static inline int tui_textarea_grow(tui_textarea_t* textarea)
 {
-  for (size_t index = 0; index < count; index++)
+  if (textarea->buffer_len >= textarea->buffer_size)
   {
-    tui_window_t* window = windows[index];
+    size_t buffer_size = textarea->buffer_size * 2;
 
-    if (window && window->event.update)
+    TUI_STATS_ADD(alloc_count, 1);
+
+    char* buffer = realloc(textarea->buffer, sizeof(char) * (buffer_size + 1));
+
+    if (!buffer)
     {
-      window->event.update(window);
+      return 1;
     }
 
-    if (window && window->type == TUI_WINDOW_PARENT)
-    {
-      tui_window_parent_t* parent = (tui_window_parent_t*) window;
+    size_t after_len = textarea->buffer_len - textarea->_gap;
 
-      tui_windows_update(parent->children, parent->child_count);
+    memmove(buffer + buffer_size - after_len, buffer + textarea->buffer_size - after_len, after_len);
+
+    textarea->buffer      = buffer;
+    textarea->buffer_size = buffer_size;
+  }
+
+  if (textarea->line_count >= textarea->line_size)
+  {
+    size_t line_size = textarea->line_size * 2;
+
+    TUI_STATS_ADD(alloc_count, 1);
+
+    size_t* lines = realloc(textarea->lines, sizeof(size_t) * line_size);
+
+    if (!lines)
+    {
+      return 1;
     }
+
+    size_t after_count = textarea->line_count - textarea->line;
+
+    memmove(lines + line_size - after_count, lines + textarea->line_size - after_count, sizeof(size_t) * after_count);
+
+    textarea->lines     = lines;
+    textarea->line_size = line_size;
   }
+
+  return 0;
 }
 
 /*
- * Update (change content) all tui windows and children
+ * Move cursor of text area to line, at the same column or at the end of the line
+ *
+ * Only the lines between the old and the new line are moved
  */
-static inline void tui_update(tui_t* tui)
+static inline void tui_textarea_line_move(tui_textarea_t* textarea, size_t line)
 {
-  tui_windows_update(tui->windows, tui->window_count);
+  line = MIN(line, textarea->line_count - 1);
 
-  tui_menu_t* menu = tui->menu;
+  size_t gap_size = textarea->line_size - textarea->line_count;
 
-  if (menu)
+  while (textarea->line > line)
   {
-    tui_windows_update(menu->windows, menu->window_count);
+    textarea->line--;
+
+    textarea->lines[textarea->line + gap_size] = textarea->lines[textarea->line];
+
+    textarea->_line_start -= textarea->lines[textarea->line] + 1;
   }
+
+  while (textarea->line < line)
+  {
+    textarea->lines[textarea->line] = textarea->lines[textarea->line + gap_size];
+
+    textarea->_line_start += textarea->lines[textarea->line] + 1;
+
+    textarea->line++;
+  }
+
+  textarea->column = MIN(textarea->column, *tui_textarea_line_get(textarea, line));
+
+  textarea->cursor = textarea->_line_start + textarea->column;
 }
 
 /*
- * Render tui - active menu and all windows
+ * Update visable string of text area
+ *
+ * Only the lines that fit in the window are in the string,
+ * starting at the line scroll, which follows the cursor
  */
-void tui_render(tui_t* tui)
+static inline void tui_textarea_string_update(tui_textarea_t* textarea)
 {
-  tui->cursor.is_active = false;
+  tui_window_text_t* window = textarea->window;
 
-  curs_set(0);
+  int h = textarea->tui->size.h;
 
-  tui_update(tui);
-
-  tui_resize(tui);
+  // The height of a window that fits its text depends on the string,
+  // so the string is made for the height of the screen
+  if (window && window->head._rect.h > 0 &&
+      (!window->head.rect.is_none || window->head.h_grow))
+  {
+    h = window->head._rect.h;
+  }
 
-  tui_menu_t* menu = tui->menu;
+  size_t view_h = MAX(1, h);
 
-  if (menu)
+  // Scroll so the line of the cursor is visable
+  if (textarea->line < textarea->scroll)
   {
-    menu->_color = tui_color_inherit(tui->color, menu->color);
-
-    tui_ncurses_window_color_on(stdscr, menu->_color);
+    textarea->scroll = textarea->line;
   }
-  else
+  else if (textarea->line >= textarea->scroll + view_h)
   {
-    tui_ncurses_window_color_on(stdscr, tui->color);
+    textarea->scroll = textarea->line - view_h + 1;
   }
 
-  tui_ncurses_window_fill(stdscr);
+  size_t end_line = MIN(textarea->line_count, textarea->scroll + view_h);
 
-  // 3. Render tui windows
-  tui_windows_render(tui->windows, tui->window_count);
+  // Get where the first visable line starts, from the line of the cursor
+  size_t start = textarea->_line_start;
 
-  // 4. Render menu windows
-  if (menu)
+  size_t string_len = 6;
+
+  for (size_t line = textarea->line; line-- > textarea->scroll;)
   {
-    tui_windows_render(menu->windows, menu->window_count);
+    start -= *tui_textarea_line_get(textarea, line) + 1;
   }
 
-  tui_cursor_t cursor = tui->cursor;
+  for (size_t line = textarea->scroll; line < end_line; line++)
+  {
+    string_len += *tui_textarea_line_get(textarea, line) + 1;
+  }
 
-  if (cursor.is_active)
+  if (string_len > textarea->string_size)
   {
-    if (cursor.y >= 0 && cursor.y < tui->size.h &&
-        cursor.x >= 0 && cursor.x < tui->size.w)
-    {
-      move(cursor.y, cursor.x);
+    size_t string_size = MAX(string_len, textarea->string_size * 2);
 
-      curs_set(1);
-    }
-  }
-}
+    TUI_STATS_ADD(alloc_count, 1);
 
-/*
- * Configuration struct for parent window
- */
-typedef struct tui_window_parent_config_t
-{
-  char*              name;
-  tui_window_event_t event;
-  tui_rect_t         rect;
-  bool               w_grow;
-  bool               h_grow;
-  tui_color_t        color;
-  bool               is_hidden;
-  bool               is_atomic;
-  bool               is_interact;
-  bool               is_contain;
-  tui_border_t       border;
-  bool               has_shadow;
-  bool               has_padding;
-  bool               has_gap;
-  tui_pos_t          pos;
-  tui_align_t        align;
-  bool               is_vertical;
-  void*              data;
-} tui_window_parent_config_t;
+    char* string = realloc(textarea->string, sizeof(char) * string_size);
 
-/*
- * Just create tui_window_parent_t* object
- */
-static inline tui_window_parent_t* _tui_window_parent_create(tui_t* tui, tui_window_parent_config_t config)
-{
-  tui_window_parent_t* window = malloc(sizeof(tui_window_parent_t));
+    if (!string) return;
 
-  if (!window)
-  {
-    return NULL;
+    textarea->string      = string;
+    textarea->string_size = string_size;
   }
 
-  memset(window, 0, sizeof(tui_window_parent_t));
+  size_t gap_size = textarea->buffer_size - textarea->buffer_len;
 
-  tui_window_t head = (tui_window_t)
-  {
-    .type        = TUI_WINDOW_PARENT,
-    .name        = config.name,
-    .rect        = config.rect,
-    .w_grow      = config.w_grow,
-    .h_grow      = config.h_grow,
-    .is_atomic   = config.is_atomic,
-    .is_hidden   = config.is_hidden,
-    ._is_visable = !config.is_hidden,
-    .is_interact = config.is_interact,
-    .is_contain  = config.is_contain,
-    .color       = config.color,
-    .event       = config.event,
-    .data        = config.data,
-    .tui         = tui
-  };
+  tui_window_t* active = textarea->tui->window;
 
-  *window = (tui_window_parent_t)
-  {
-    .head        = head,
-    .has_padding = config.has_padding,
-    .has_gap     = config.has_gap,
-    .border      = config.border,
-    .has_shadow  = config.has_shadow,
-    .pos         = config.pos,
-    .align       = config.align,
-    .is_vertical = config.is_vertical,
-  };
+  bool is_active = active && (tui_window_t*) window == active;
 
-  return window;
-}
+  size_t cursor = 0;
 
-/*
- * Set string of text window to copy of specified string
- */
-void tui_window_text_string_set(tui_window_text_t* window, char* string)
-{
-  if (window && string)
+  string_len = 0;
+
+  size_t index = start;
+
+  for (size_t line = textarea->scroll; line < end_line; line++)
   {
-    size_t length = strlen(string);
+    size_t line_len = *tui_textarea_line_get(textarea, line);
 
-    if (length >= window->string_size)
+    for (size_t column = 0; column <= line_len; column++, index++)
     {
-      free(window->string);
+      if (index == textarea->cursor)
+      {
+        cursor = string_len;
 
-      window->string = malloc(sizeof(char) * (length + 1));
+        memcpy(textarea->string + string_len, "\033[5m", 4);
 
-      window->string_size = length + 1;
+        string_len += 4;
+
+        // At the end of the line, add space for cursor
+        if (column == line_len && is_active)
+        {
+          textarea->string[string_len++] = ' ';
+        }
+      }
+
+      if (column < line_len)
+      {
+        textarea->string[string_len++] = textarea->buffer[(index < textarea->_gap) ? index : index + gap_size];
+      }
     }
-    
-    if (window->string)
-    {
-      strcpy(window->string, string);
 
-      window->string[length] = '\0';
+    if (line + 1 < end_line)
+    {
+      textarea->string[string_len++] = '\n';
     }
   }
-}
 
-/*
- * Configuration struct for text window
- */
-typedef struct tui_window_text_config_t
-{
-  char*              name;
-  tui_window_event_t event;
-  tui_rect_t         rect;
-  bool               w_grow;
-  bool               h_grow;
-  tui_color_t        color;
-  bool               is_hidden;
-  bool               is_atomic;
-  bool               is_interact;
-  bool               is_contain;
-  char*              string;
-  bool               is_secret;
-  tui_pos_t          pos;
-  tui_align_t        align;
-  void*              data;
-} tui_window_text_config_t;
+  textarea->string[string_len] = '\0';
+
+  // The string is given to the text window directly, without parsing it
+  if (window)
+  {
+    tui_window_text_cursor_set(window, textarea->string, string_len, cursor);
+  }
+}
 
 /*
- * Just create tui_window_text_t* object
+ * Add symbol, or new line, to text area at the cursor
  */
-static inline tui_window_text_t* _tui_window_text_create(tui_t* tui, tui_window_text_config_t config)
+static inline bool tui_textarea_symbol_add(tui_textarea_t* textarea, int key)
 {
-  tui_window_text_t* window = malloc(sizeof(tui_window_text_t));
-
-  if (!window)
+  if ((key < 32 || key > 126) && key != KEY_ENTR)
   {
-    return NULL;
+    return false;
   }
 
-  memset(window, 0, sizeof(tui_window_text_t));
-
-  tui_window_t head = (tui_window_t)
+  if (tui_textarea_grow(textarea) != 0)
   {
-    .type        = TUI_WINDOW_TEXT,
-    .name        = config.name,
-    .rect        = config.rect,
-    .w_grow      = config.w_grow,
-    .h_grow      = config.h_grow,
-    .is_atomic   = config.is_atomic,
-    .is_hidden   = config.is_hidden,
-    ._is_visable = !config.is_hidden,
-    .is_interact = config.is_interact,
-    .is_contain  = config.is_contain,
-    .color       = config.color,
-    .event       = config.event,
-    .data        = config.data,
-    .tui         = tui
-  };
+    return false;
+  }
 
-  *window = (tui_window_text_t)
-  {
-    .head      = head,
-    .is_secret = config.is_secret,
-    .pos       = config.pos,
-    .align     = config.align
-  };
+  tui_gap_move(textarea->buffer, textarea->buffer_size - textarea->buffer_len, &textarea->_gap, textarea->cursor);
 
-  char* string = config.string ? config.string : "";
+  textarea->buffer[textarea->_gap++] = (key == KEY_ENTR) ? '\n' : key;
 
-  tui_window_text_string_set(window, string);
+  textarea->buffer_len++;
 
-  return window;
-}
+  textarea->cursor++;
 
-/*
- * Configuration struct for grid window
- */
-typedef struct tui_window_grid_config_t
-{
-  char*              name;
-  tui_window_event_t event;
-  tui_rect_t         rect;
-  bool               w_grow;
-  bool               h_grow;
-  tui_color_t        color;
-  bool               is_hidden;
-  bool               is_atomic;
-  bool               is_interact;
-  bool               is_contain;
-  tui_size_t         size;
-  void*              data;
-} tui_window_grid_config_t;
+  // The line of the cursor is after the gap of lines
+  size_t* line_len = tui_textarea_line_get(textarea, textarea->line);
 
-/*
- * Resize grid and store size in _size
- */
-int tui_window_grid_resize(tui_window_grid_t* window, tui_size_t size)
-{
-  if (size.w <= 0 || size.h <= 0)
+  if (key == KEY_ENTR)
   {
-    return 1;
-  }
+    // The line is split at the cursor, and the first part ends up before the gap
+    size_t rest_len = *line_len - textarea->column;
 
-  free(window->grid);
+    textarea->lines[textarea->line] = textarea->column;
 
-  int square_count = size.w * size.h;
+    *line_len = rest_len;
 
-  tui_window_grid_square_t* grid = malloc(sizeof(tui_window_grid_square_t) * square_count);
+    textarea->line_count++;
 
-  if (!grid)
-  {
-    return 2;
-  }
+    textarea->line++;
 
-  memset(grid, 0, sizeof(tui_window_grid_square_t) * square_count);
+    textarea->column = 0;
 
-  window->grid = grid;
+    textarea->_line_start = textarea->cursor;
+  }
+  else
+  {
+    (*line_len)++;
 
-  window->_size = size;
+    textarea->column++;
+  }
 
-  return 0;
+  tui_textarea_string_update(textarea);
+
+  return true;
 }
 
 /*
- * Just create tui_window_grid_t* object
+ * Delete symbol, or new line, before the cursor in text area
  */
-static inline tui_window_grid_t* _tui_window_grid_create(tui_t* tui, tui_window_grid_config_t config)
+static inline bool tui_textarea_symbol_del(tui_textarea_t* textarea)
 {
-  tui_window_grid_t* window = malloc(sizeof(tui_window_grid_t));
-
-  if (!window)
+  if (textarea->cursor == 0)
   {
-    return NULL;
+    return false;
   }
 
-  memset(window, 0, sizeof(tui_window_grid_t));
+  tui_gap_move(textarea->buffer, textarea->buffer_size - textarea->buffer_len, &textarea->_gap, textarea->cursor);
 
-  tui_window_t head = (tui_window_t)
+  textarea->_gap--;
+
+  textarea->buffer_len--;
+
+  textarea->cursor--;
+
+  size_t* line_len = tui_textarea_line_get(textarea, textarea->line);
+
+  if (textarea->column == 0)
   {
-    .type        = TUI_WINDOW_GRID,
-    .name        = config.name,
-    .rect        = config.rect,
-    .w_grow      = config.w_grow,
-    .h_grow      = config.h_grow,
-    .is_atomic   = config.is_atomic,
-    .is_hidden   = config.is_hidden,
-    ._is_visable = !config.is_hidden,
-    .is_interact = config.is_interact,
-    .is_contain  = config.is_contain,
-    .color       = config.color,
-    .event       = config.event,
-    .data        = config.data,
-    .tui         = tui
-  };
+    // The line is joined with the line before it, that is before the gap
+    textarea->line--;
+
+    textarea->line_count--;
+
+    size_t prev_len = textarea->lines[textarea->line];
 
-  *window = (tui_window_grid_t)
-  {
-    .head = head,
-    .size = config.size,
-  };
+    *line_len += prev_len;
 
-  if (tui_window_grid_resize(window, config.size) != 0)
+    textarea->column = prev_len;
+
+    textarea->_line_start -= prev_len + 1;
+  }
+  else
   {
-    free(window);
+    (*line_len)--;
 
-    return NULL;
+    textarea->column--;
   }
 
-  return window;
+  tui_textarea_string_update(textarea);
+
+  return true;
 }
 
 /*
- * Append window to array of windows
+ * Move cursor in text area one symbol to the left or to the right
  */
-static inline int tui_windows_window_append(tui_window_t*** windows, size_t* count, tui_window_t* window)
+static inline bool tui_textarea_cursor_move(tui_textarea_t* textarea, bool is_right)
 {
-  tui_window_t** temp_windows = realloc(*windows, sizeof(tui_window_t*) * (*count + 1));
+  size_t line_len = *tui_textarea_line_get(textarea, textarea->line);
 
-  if (!temp_windows)
+  if (is_right)
   {
-    return 1;
+    if (textarea->column < line_len)
+    {
+      textarea->column++;
+
+      textarea->cursor++;
+    }
+    else if (textarea->line + 1 < textarea->line_count)
+    {
+      textarea->column = 0;
+
+      tui_textarea_line_move(textarea, textarea->line + 1);
+    }
+    else return false;
   }
+  else
+  {
+    if (textarea->column > 0)
+    {
+      textarea->column--;
 
-  *windows = temp_windows;
+      textarea->cursor--;
+    }
+    else if (textarea->line > 0)
+    {
+      textarea->column = SIZE_MAX;
 
-  (*windows)[*count] = window;
+      tui_textarea_line_move(textarea, textarea->line - 1);
+    }
+    else return false;
+  }
 
-  (*count)++;
+  tui_textarea_string_update(textarea);
 
-  return 0;
+  return true;
 }
 
 /*
- * Append window to tui windows
+ * Move cursor in text area to another line
  */
-static inline int tui_window_append(tui_t* tui, tui_window_t* window)
+static inline bool tui_textarea_cursor_line_move(tui_textarea_t* textarea, ssize_t amount)
 {
-  return tui_windows_window_append(&tui->windows, &tui->window_count, window);
-}
+  size_t line = textarea->line;
 
-/*
- * Append window to menu windows, and store menu reference in window
- */
-static inline int tui_menu_window_append(tui_menu_t* menu, tui_window_t* window)
-{
-  window->menu = menu;
+  if (amount < 0)
+  {
+    line = (line > (size_t) -amount) ? line + amount : 0;
+  }
+  else
+  {
+    line = MIN(line + amount, textarea->line_count - 1);
+  }
+
+  if (line == textarea->line)
+  {
+    return false;
+  }
 
-  return tui_windows_window_append(&menu->windows, &menu->window_count, window);
+  tui_textarea_line_move(textarea, line);
+
+  tui_textarea_string_update(textarea);
+
+  return true;
 }
 
 /*
- * Append child to parent children, and store parent and menu reference in child
+ * Get text of text area, as a string
+ *
+ * The gap is moved to the end of the buffer, so the text is in one piece
  */
-static inline int tui_parent_child_append(tui_window_parent_t* parent, tui_window_t* child)
+char* tui_textarea_buffer_get(tui_textarea_t* textarea)
 {
-  child->parent = parent;
-  child->menu   = parent->head.menu;
+  tui_gap_move(textarea->buffer, textarea->buffer_size - textarea->buffer_len, &textarea->_gap, textarea->buffer_len);
 
-  return tui_windows_window_append(&parent->children, &parent->child_count, child);
+  textarea->buffer[textarea->buffer_len] = '\0';
+
+  return textarea->buffer;
 }
 
 /*
- * Create parent window and add it to tui
+ * Set text of text area, with the cursor at the start
  */
-tui_window_parent_t* tui_window_parent_create(tui_t* tui, tui_window_parent_config_t config)
+int tui_textarea_buffer_set(tui_textarea_t* textarea, char* text)
 {
-  tui_window_parent_t* window = _tui_window_parent_create(tui, config);
+  size_t length = strlen(text);
 
-  if (!window)
+  size_t line_count = 1;
+
+  for (size_t index = 0; index < length; index++)
   {
-    return NULL;
+    if (text[index] == '\n') line_count++;
   }
 
-  if (tui_window_append(tui, (tui_window_t*) window) != 0)
+  if (length > textarea->buffer_size)
   {
-    tui_window_parent_free(&window);
+    TUI_STATS_ADD(alloc_count, 1);
 
-    return NULL;
+    char* buffer = realloc(textarea->buffer, sizeof(char) * (length + 1));
+
+    if (!buffer)
+    {
+      return 1;
+    }
+
+    textarea->buffer      = buffer;
+    textarea->buffer_size = length;
   }
 
-  if (window->head.event.init)
+  if (line_count > textarea->line_size)
   {
-    window->head.event.init((tui_window_t*) window);
-  }
+    TUI_STATS_ADD(alloc_count, 1);
 
-  return window;
-}
+    size_t* lines = realloc(textarea->lines, sizeof(size_t) * line_count);
 
-/*
- * Create parent window and add it to menu
- */
-tui_window_parent_t* tui_menu_window_parent_create(tui_menu_t* menu, tui_window_parent_config_t config)
-{
-  tui_window_parent_t* window = _tui_window_parent_create(menu->tui, config);
+    if (!lines)
+    {
+      return 1;
+    }
 
-  if (!window)
-  {
-    return NULL;
+    textarea->lines     = lines;
+    textarea->line_size = line_count;
   }
 
-  if (tui_menu_window_append(menu, (tui_window_t*) window) != 0)
-  {
-    tui_window_parent_free(&window);
+  // Every line is after the gap, because the cursor is on the first line
+  size_t gap_size = textarea->buffer_size - length;
 
-    return NULL;
-  }
+  memcpy(textarea->buffer + gap_size, text, length);
 
-  if (window->head.event.init)
+  size_t* lines = textarea->lines + (textarea->line_size - line_count);
+
+  size_t line = 0;
+
+  lines[0] = 0;
+
+  for (size_t index = 0; index < length; index++)
   {
-    window->head.event.init((tui_window_t*) window);
+    if (text[index] == '\n')
+    {
+      lines[++line] = 0;
+    }
+    else
+    {
+      lines[line]++;
+    }
   }
 
-  return window;
+  textarea->buffer_len  = length;
+  textarea->_gap        = 0;
+  textarea->cursor      = 0;
+  textarea->line_count  = line_count;
+  textarea->line        = 0;
+  textarea->column      = 0;
+  textarea->_line_start = 0;
+  textarea->scroll      = 0;
+
+  tui_textarea_string_update(textarea);
+
+  return 0;
 }
 
 /*
- * Create parent window and add it to window as child
+ * Create text area struct
+ *
+ * The text area grows when text is added, starting at size characters
  */
-tui_window_parent_t* tui_parent_child_parent_create(tui_window_parent_t* parent, tui_window_parent_config_t config)
+tui_textarea_t* tui_textarea_create(tui_t* tui, size_t size, tui_window_text_t* window)
 {
-  tui_window_parent_t* child = _tui_window_parent_create(parent->head.tui, config);
+  TUI_STATS_ADD(alloc_count, 1);
 
-  if (!child)
+  tui_textarea_t* textarea = malloc(sizeof(tui_textarea_t));
+
+  if (!textarea)
   {
     return NULL;
   }
 
-  if (tui_parent_child_append(parent, (tui_window_t*) child) != 0)
+  memset(textarea, 0, sizeof(tui_textarea_t));
+
+  *textarea = (tui_textarea_t)
   {
-    tui_window_parent_free(&child);
+    .buffer_size = MAX(1, size),
+    .line_size   = 16,
+    .line_count  = 1,
+    .window      = window,
+    .tui         = tui,
+  };
 
-    return NULL;
-  }
 
-  if (child->head.event.init)
+  TUI_STATS_ADD(alloc_count, 2);
+
+  textarea->buffer = malloc(sizeof(char) * (textarea->buffer_size + 1));
+
+  textarea->lines = malloc(sizeof(size_t) * textarea->line_size);
+
+  if (!textarea->buffer || !textarea->lines)
   {
-    child->head.event.init((tui_window_t*) child);
+    free(textarea->buffer);
+
+    free(textarea->lines);
+
+    free(textarea);
+
+    return NULL;
   }
 
-  return child;
+  // The only line is empty, and the line of the cursor is after the gap
+  textarea->lines[textarea->line_size - 1] = 0;
+
+  tui_textarea_string_update(textarea);
+
+  return textarea;
 }
 
 /*
- * Create text window and add it to tui
+ * Delete text area struct
  */
-tui_window_text_t* tui_window_text_create(tui_t* tui, tui_window_text_config_t config)
+void tui_textarea_delete(tui_textarea_t** textarea)
 {
-  tui_window_text_t* window = _tui_window_text_create(tui, config);
+  if (!textarea || !(*textarea)) return;
 
-  if (!window)
-  {
-    return NULL;
-  }
+  free((*textarea)->buffer);
 
-  if (tui_window_append(tui, (tui_window_t*) window) != 0)
-  {
-    tui_window_text_free(&window);
+  free((*textarea)->lines);
 
-    return NULL;
-  }
+  free((*textarea)->string);
 
-  if (window->head.event.init)
-  {
-    window->head.event.init((tui_window_t*) window);
-  }
+  free(*textarea);
 
-  return window;
+  *textarea = NULL;
 }
 
 /*
- * Create text window and add it to menu
+ * Handle keypress in text area window
  */
-tui_window_text_t* tui_menu_window_text_create(tui_menu_t* menu, tui_window_text_config_t config)
+bool tui_textarea_event(tui_textarea_t* textarea, int key)
 {
-  tui_window_text_t* window = _tui_window_text_create(menu->tui, config);
-
-  if (!window)
+  // If text area window is not the active window, it can't be changed
+  if (!textarea->window || textarea->tui->window != (tui_window_t*) textarea->window)
   {
-    return NULL;
+    return false;
   }
 
-  if (tui_menu_window_append(menu, (tui_window_t*) window) != 0)
-  {
-    tui_window_text_free(&window);
+  tui_window_text_t* window = textarea->window;
 
-    return NULL;
-  }
+  ssize_t page_h = MAX(1, window->head._rect.h - 1);
 
-  if (window->head.event.init)
+  switch (key)
   {
-    window->head.event.init((tui_window_t*) window);
+    case KEY_RIGHT:
+      return tui_textarea_cursor_move(textarea, true);
+
+    case KEY_LEFT:
+      return tui_textarea_cursor_move(textarea, false);
+
+    case KEY_DOWN:
+      return tui_textarea_cursor_line_move(textarea, 1);
+
+    case KEY_UP:
+      return tui_textarea_cursor_line_move(textarea, -1);
+
+    case KEY_NPAGE:
+      return tui_textarea_cursor_line_move(textarea, page_h);
+
+    case KEY_PPAGE:
+      return tui_textarea_cursor_line_move(textarea, -page_h);
+
+    case KEY_BACKSPACE:
+      return tui_textarea_symbol_del(textarea);
+
+    default:
+      return tui_textarea_symbol_add(textarea, key);
   }
 
-  return window;
+  return false;
 }
 
 /*
- * Create text window and add it to window as child
+ * Add item to list
  */
-tui_window_text_t* tui_parent_child_text_create(tui_window_parent_t* parent, tui_window_text_config_t config)
+int tui_list_item_add(tui_list_t* list, tui_window_t* item)
 {
-  tui_window_text_t* child = _tui_window_text_create(parent->head.tui, config);
-
-  if (!child)
+  if (list->item_count >= list->item_size)
   {
-    return NULL;
-  }
+    size_t item_size = MAX(4, list->item_size * 2);
 
-  if (tui_parent_child_append(parent, (tui_window_t*) child) != 0)
-  {
-    tui_window_text_free(&child);
+    TUI_STATS_ADD(alloc_count, 1);
 
-    return NULL;
-  }
+    tui_window_t** temp_items = realloc(list->items, sizeof(tui_window_t*) * item_size);
 
-  if (child->head.event.init)
-  {
-    child->head.event.init((tui_window_t*) child);
+    if (!temp_items)
+    {
+      return 1;
+    }
+
+    list->items = temp_items;
+
+    list->item_size = item_size;
   }
 
-  return child;
+  list->items[list->item_count++] = item;
+
+  return 0;
 }
 
 /*
- * Create grid window and add it to tui
+ * Update list item by changing to another if it is invisable
+ *
+ * RETURN (bool changed)
  */
-tui_window_grid_t* tui_window_grid_create(tui_t* tui, tui_window_grid_config_t config)
+bool tui_list_item_update(tui_list_t* list)
 {
-  tui_window_grid_t* window = _tui_window_grid_create(tui, config);
+  // The rows of a virtual list always show the selected item
+  if (list->row) return false;
 
-  if (!window)
-  {
-    return NULL;
-  }
+  tui_window_t* item = list->items[list->item_index];
 
-  if (tui_window_append(tui, (tui_window_t*) window) != 0)
+  if (!item->_is_visable)
   {
-    tui_window_grid_free(&window);
+    for (size_t index = list->item_index + 1; index < list->item_count; index++)
+    {
+      item = list->items[index];
 
-    return NULL;
-  }
+      if (item->_is_visable)
+      {
+        list->item_index = index;
 
-  if (window->head.event.init)
-  {
-    window->head.event.init((tui_window_t*) window);
+        return true;
+      }
+    }
+
+    for (size_t index = list->item_index; index-- > 0;)
+    {
+      item = list->items[index];
+
+      if (item->_is_visable)
+      {
+        list->item_index = index;
+
+        return true;
+      }
+    }
   }
 
-  return window;
+  return false;
 }
 
 /*
- * Create grid window and add it to menu
+ * Create list struct
  */
-tui_window_grid_t* tui_menu_window_grid_create(tui_menu_t* menu, tui_window_grid_config_t config)
+tui_list_t* tui_list_create(tui_t* tui, bool is_vertical)
 {
-  tui_window_grid_t* window = _tui_window_grid_create(menu->tui, config);
+  TUI_STATS_ADD(alloc_count, 1);
 
-  if (!window)
-  {
-    return NULL;
-  }
+  tui_list_t* list = malloc(sizeof(tui_list_t));
 
-  if (tui_menu_window_append(menu, (tui_window_t*) window) != 0)
+  if (!list)
   {
-    tui_window_grid_free(&window);
-
     return NULL;
   }
 
-  if (window->head.event.init)
+  memset(list, 0, sizeof(tui_list_t));
+
+  *list = (tui_list_t)
   {
-    window->head.event.init((tui_window_t*) window);
-  }
+    .is_vertical = is_vertical,
+    .tui         = tui,
+  };
 
-  return window;
+  return list;
 }
 
 /*
- * Create grid window and add it to window as child
+ * Add rows to virtual list, until there is a row for every line of the screen
+ *
+ * Rows are atomic, so the rows that don't fit in the parent are invisable
  */
-tui_window_grid_t* tui_parent_child_grid_create(tui_window_parent_t* parent, tui_window_grid_config_t config)
+static inline int tui_list_rows_grow(tui_list_t* list)
 {
-  tui_window_grid_t* child = _tui_window_grid_create(parent->head.tui, config);
+  size_t row_count = list->is_vertical ? getmaxy(stdscr) : getmaxx(stdscr);
 
-  if (!child)
+  if (row_count <= list->row_count)
   {
-    return NULL;
+    return 0;
   }
 
-  if (tui_parent_child_append(parent, (tui_window_t*) child) != 0)
+  if (row_count > list->row_size)
   {
-    tui_window_grid_free(&child);
+    TUI_STATS_ADD(alloc_count, 1);
 
-    return NULL;
+    tui_window_text_t** temp_rows = realloc(list->rows, sizeof(tui_window_text_t*) * row_count);
+
+    if (!temp_rows)
+    {
+      return 1;
+    }
+
+    list->rows = temp_rows;
+
+    list->row_size = row_count;
   }
 
-  if (child->head.event.init)
+  while (list->row_count < row_count)
   {
-    child->head.event.init((tui_window_t*) child);
+    tui_window_text_t* row = tui_parent_child_text_create(list->parent, (tui_window_text_config_t)
+    {
+      .rect      = TUI_RECT_NONE,
+      .string    = "",
+      .is_hidden = true,
+      .is_atomic = true,
+      .w_grow    = list->is_vertical,
+      .h_grow    = !list->is_vertical,
+      .data      = list,
+    });
+
+    if (!row)
+    {
+      return 2;
+    }
+
+    list->rows[list->row_count++] = row;
   }
 
-  return child;
+  list->_is_dirty = true;
+
+  return 0;
 }
 
 /*
- * Get square at x y in grid window
+ * Get amount of rows that were visable in the last layout
  */
-tui_window_grid_square_t* tui_window_grid_square_get(tui_window_grid_t* window, int x, int y)
+static inline size_t tui_list_view_count(tui_list_t* list)
 {
-  if (x >= 0 && x < window->_size.w &&
-      y >= 0 && y < window->_size.h)
-  {
-    int index = y * window->_size.w + x;
+  size_t count = 0;
 
-    return &window->grid[index];
+  while (count < list->row_count && list->rows[count]->head._is_visable)
+  {
+    count++;
   }
 
-  return NULL;
+  return count;
 }
 
 /*
- * Set color and symbol of square in grid window
+ * Set content of row to the item it is showing, or hide it
  */
-void tui_window_grid_square_set(tui_window_grid_t* window, int x, int y, tui_window_grid_square_t square)
+static inline void tui_list_row_update(tui_list_t* list, size_t row_index)
 {
-  tui_window_grid_square_t* old_square = tui_window_grid_square_get(window, x, y);
+  tui_window_text_t* row = list->rows[row_index];
 
-  if (old_square)
+  size_t index = list->scroll + row_index;
+
+  row->head.is_hidden = (index >= list->item_count);
+
+  if (!row->head.is_hidden)
   {
-    *old_square = square;
+    list->row(list, row, list->indexes ? list->indexes[index] : index);
   }
 }
 
 /*
- * Modify grid square by changing symbol or color if specified
+ * Get index of item at position in list
+ *
+ * If the list is filtered, the position is not the same as the index
  */
-void tui_window_grid_square_modify(tui_window_grid_t* window, int x, int y, tui_window_grid_square_t square)
+size_t tui_list_index_get(tui_list_t* list, size_t position)
 {
-  tui_window_grid_square_t* old_square = tui_window_grid_square_get(window, x, y);
-
-  if (old_square)
-  {
-    if (square.color.fg != TUI_COLOR_NONE)
-    {
-      old_square->color.fg = square.color.fg;
-    }
-
-    if (square.color.bg != TUI_COLOR_NONE)
-    {
-      old_square->color.bg = square.color.bg;
-    }
-
-    if (square.symbol)
-    {
-      old_square->symbol = square.symbol;
-    }
-  }
+  return list->indexes ? list->indexes[position] : position;
 }
 
 /*
- * Update visable string from input buffer
+ * Update rows of virtual list
  *
- * The buffer can for example be partially visable
+ * The list scrolls to keep the selected item visable,
+ * and only the rows whose item has changed are updated
+ *
+ * Call this in the update event of the parent,
+ * to show more rows when the terminal gets bigger
  */
-static inline void tui_input_string_update(tui_input_t* input)
+void tui_list_update(tui_list_t* list)
 {
-  size_t string_len = 0;
+  if (!list || !list->row) return;
 
-  for (size_t index = input->scroll; index < input->cursor; index++)
+  tui_list_rows_grow(list);
+
+  if (list->item_index >= list->item_count)
   {
-    input->string[string_len++] = input->buffer[index];
+    list->item_index = list->item_count ? list->item_count - 1 : 0;
   }
 
-  strcpy(input->string + string_len, "\033[5m");
-
-  string_len += 4;
+  size_t view_count = tui_list_view_count(list);
 
-  for (size_t index = input->cursor; index < input->buffer_len; index++)
+  if (list->item_index < list->scroll)
   {
-    input->string[string_len++] = input->buffer[index];
+    list->scroll = list->item_index;
+  }
+  else if (view_count > 0 && list->item_index >= list->scroll + view_count)
+  {
+    list->scroll = list->item_index - view_count + 1;
   }
 
-  tui_window_t* window = input->tui->window;
-
-  // If the cursor is at the end of the string,
-  // and input text window is the active window,
-  // add space for cursor
-  if (input->cursor == input->buffer_len &&
-      window && (tui_window_t*) input->window == window)
+  if (list->_is_dirty || list->scroll != list->_last_scroll)
   {
-    input->string[string_len++] = ' ';
+    for (size_t row_index = 0; row_index < list->row_count; row_index++)
+    {
+      tui_list_row_update(list, row_index);
+    }
   }
+  else if (list->item_index != list->_last_index)
+  {
+    // Only the rows of the old and the new selected item have changed
+    size_t indexes[] = { list->_last_index, list->item_index };
 
-  input->string[string_len] = '\0';
+    for (size_t index = 0; index < 2; index++)
+    {
+      if (indexes[index] >= list->scroll &&
+          indexes[index] < list->scroll + list->row_count)
+      {
+        tui_list_row_update(list, indexes[index] - list->scroll);
+      }
+    }
+  }
+
+  list->_last_scroll = list->scroll;
+  list->_last_index  = list->item_index;
+  list->_is_dirty    = false;
 }
 
 /*
- * Create input struct
+ * Create virtual list struct, with rows as children of parent
+ *
+ * The content of the row of an item is set by the row callback
  */
-tui_input_t* tui_input_create(tui_t* tui, size_t size, tui_window_text_t* window)
+tui_list_t* tui_list_virtual_create(tui_t* tui, tui_window_parent_t* parent, size_t count, tui_list_row_t row)
 {
-  tui_input_t* input = malloc(sizeof(tui_input_t));
-
-  if (!input)
+  if (!parent || !row)
   {
     return NULL;
   }
 
-  memset(input, 0, sizeof(tui_input_t));
+  tui_list_t* list = tui_list_create(tui, parent->is_vertical);
 
-  *input = (tui_input_t)
+  if (!list)
   {
-    .buffer_size = size,
-    .tui         = tui,
-    .window      = window,
-  };
+    return NULL;
+  }
 
+  list->parent     = parent;
+  list->row        = row;
+  list->item_count = count;
+  list->_is_dirty  = true;
 
-  input->buffer = malloc(sizeof(char) * (size + 1));
+  tui_list_update(list);
 
-  if (!input->buffer)
-  {
-    free(input);
+  return list;
+}
 
-    return NULL;
-  }
+/*
+ * Set amount of items in virtual list
+ *
+ * Every row is updated, even if the amount is the same
+ */
+void tui_list_count_set(tui_list_t* list, size_t count)
+{
+  if (!list || !list->row) return;
 
-  memset(input->buffer, '\0', sizeof(char) * (size + 1));
+  list->item_count = count;
 
+  list->_is_dirty = true;
 
-  input->string = malloc(sizeof(char) * (size + 6));
+  tui_list_update(list);
+}
 
-  if (!input->string)
-  {
-    free(input->buffer);
+/*
+ * Delete list struct
+ *
+ * The rows of a virtual list are deleted with their parent
+ */
+void tui_list_delete(tui_list_t** list)
+{
+  if (!list || !(*list)) return;
 
-    free(input);
+  free((*list)->items);
 
-    return NULL;
-  }
+  free((*list)->rows);
 
-  tui_input_string_update(input);
+  free(*list);
 
-  return input;
+  *list = NULL;
 }
 
 /*
- * Delete input struct
+ * Scroll forward to next selected item
  */
-void tui_input_delete(tui_input_t** input)
+static inline bool tui_list_scroll_forward(tui_list_t* list)
 {
-  if (!input || !(*input)) return;
+  if (list->row)
+  {
+    if (list->item_index + 1 >= list->item_count) return false;
 
-  free((*input)->buffer);
+    list->item_index++;
 
-  free((*input)->string);
+    tui_list_update(list);
 
-  free(*input);
+    return true;
+  }
 
-  *input = NULL;
+  for (size_t index = list->item_index + 1; index < list->item_count; index++)
+  {
+    tui_window_t* window = list->items[index];
+
+    if (window && window->_is_visable)
+    {
+      list->item_index = index;
+
+      return true;
+    }
+  }
+
+  return false;
 }
 
 /*
- * Add symbol to input buffer
+ * Scroll backwards to next selected item
  */
-static inline bool tui_input_symbol_add(tui_input_t* input, int key)
+static inline bool tui_list_scroll_backward(tui_list_t* list)
 {
-  if (input->buffer_len >= input->buffer_size)
+  if (list->row)
   {
-    return false;
+    if (list->item_index == 0) return false;
+
+    list->item_index--;
+
+    tui_list_update(list);
+
+    return true;
   }
 
-  if (key < 32 || key > 126)
+  for (size_t index = list->item_index; index-- > 0;)
   {
-    return false;
-  }
+    tui_window_t* window = list->items[index];
 
-  char symbol = key;
+    if (window && window->_is_visable)
+    {
+      list->item_index = index;
 
-  // Shift characters forward to make room for new character
-  for (size_t index = input->buffer_len + 1; index-- > (input->cursor + 1);)
-  {
-    input->buffer[index] = input->buffer[index - 1];
+      return true;
+    }
   }
 
-  input->buffer[input->cursor] = symbol;
+  return false;
+}
 
-  input->buffer_len++;
+/*
+ * Scroll virtual list a page of visable rows forward or backwards
+ */
+static inline bool tui_list_scroll_page(tui_list_t* list, bool is_forward)
+{
+  if (!list->row || list->item_count == 0) return false;
 
+  size_t page = MAX(1, tui_list_view_count(list));
 
-  if (input->cursor < input->buffer_len)
+  size_t item_index = list->item_index;
+
+  if (is_forward)
   {
-    input->cursor++;
+    list->item_index = MIN(list->item_count - 1, item_index + page);
   }
-
-  // The cursor is at the end of the input window
-  /*
-  if((win->cursor - win->scroll) >= (win->head.w - 2))
+  else
   {
-    win->scroll++; // Scroll one more character
+    list->item_index = (item_index > page) ? item_index - page : 0;
   }
-  */
 
-  tui_input_string_update(input);
+  if (list->item_index == item_index) return false;
+
+  tui_list_update(list);
 
   return true;
 }
 
 /*
- * Delete symbol from input buffer
+ * Handle list event
  */
-static inline bool tui_input_symbol_del(tui_input_t* input)
+bool tui_list_event(tui_list_t* list, int key)
 {
-  if (input->cursor <= 0 || input->buffer_len <= 0)
+  if (list->is_vertical)
   {
-    return false;
-  }
+    switch (key)
+    {
+      case KEY_DOWN: case KEY_TAB:
+        return tui_list_scroll_forward(list);
+
+      case KEY_UP: case KEY_RTAB:
+        return tui_list_scroll_backward(list);
+
+      case KEY_NPAGE:
+        return tui_list_scroll_page(list, true);
+
+      case KEY_PPAGE:
+        return tui_list_scroll_page(list, false);
 
-  // Fill in the room left by the deleted character
-  for (size_t index = input->cursor - 1; index < input->buffer_len; index++)
+      default:
+        break;
+    }
+  }
+  else
   {
-    input->buffer[index] = input->buffer[index + 1];
+    switch (key)
+    {
+      case KEY_RIGHT: case KEY_TAB:
+        return tui_list_scroll_forward(list);
+
+      case KEY_LEFT: case KEY_RTAB:
+        return tui_list_scroll_backward(list);
+
+      default:
+        break;
+    }
   }
 
-  input->buffer_len--;
+  return false;
+}
+
+/*
+ * Check if string contains query, ignoring case
+ */
+static inline bool tui_string_query_find(const char* string, const char* query, size_t length)
+{
+  if (length == 0) return true;
+
+  int first = tolower((unsigned char) query[0]);
+
+  for (; *string; string++)
+  {
+    if (tolower((unsigned char) *string) != first) continue;
 
-  input->buffer[input->buffer_len] = '\0';
+    size_t index = 1;
 
-  input->cursor = MIN(input->cursor - 1, input->buffer_len);
+    while (index < length && string[index] &&
+           tolower((unsigned char) string[index]) == tolower((unsigned char) query[index]))
+    {
+      index++;
+    }
 
-  tui_input_string_update(input);
+    if (index == length) return true;
+  }
 
-  return true;
+  return false;
 }
 
 /*
- * Scroll right in input buffer
+ * Get string of item in list of filter
+ *
+ * Without a string callback, the text of text windows are used
  */
-static inline bool tui_input_scroll_right(tui_input_t* input)
+static inline char* tui_filter_string_get(tui_filter_t* filter, size_t index)
 {
-  // If input text window is not the active window, scrolling is disabled
-  if (!input->window || input->tui->window != (tui_window_t*) input->window)
+  if (filter->string)
   {
-    return false;
+    return filter->string(filter->list, index);
   }
 
-  // The cursor can not be further than the text itself
-  if (input->cursor >= input->buffer_len)
+  tui_window_t* item = filter->list->items ? filter->list->items[index] : NULL;
+
+  if (item && item->type == TUI_WINDOW_TEXT)
   {
-    return false;
+    return ((tui_window_text_t*) item)->text;
   }
 
-  input->cursor++;
-
-  tui_input_string_update(input);
-
-  return true;
+  return NULL;
 }
 
 /*
- * Scroll left in input buffer
+ * Match the items of the level before against the query of level
+ *
+ * Level 0 is every item, and the matches of level are stored after the level before
  */
-static inline bool tui_input_scroll_left(tui_input_t* input)
+static inline int tui_filter_level_match(tui_filter_t* filter, size_t level)
 {
-  // If input text window is not the active window, scrolling is disabled
-  if (!input->window || input->tui->window != (tui_window_t*) input->window)
-  {
-    return false;
-  }
+  size_t start = (level > 1) ? filter->_levels[level - 2] : 0;
+  size_t end   = filter->_levels[level - 1];
 
-  // Can't scroll past the beginning
-  if (input->cursor == 0)
+  size_t count = (level > 1) ? (end - start) : filter->item_count;
+
+  if (end + count > filter->match_size)
   {
-    return false;
+    size_t match_size = MAX(end + count, filter->match_size * 2);
+
+    TUI_STATS_ADD(alloc_count, 1);
+
+    size_t* temp_matches = realloc(filter->matches, sizeof(size_t) * match_size);
+
+    if (!temp_matches)
+    {
+      return 1;
+    }
+
+    filter->matches = temp_matches;
+
+    filter->match_size = match_size;
   }
 
-  input->cursor--;
+  size_t match_count = end;
 
-  // If the cursor is to the left of the window,
-  // scroll to the start of the cursor
-  if (input->cursor < input->scroll)
+  for (size_t index = 0; index < count; index++)
   {
-    input->scroll = input->cursor;
+    size_t item = (level > 1) ? filter->matches[start + index] : index;
+
+    char* string = tui_filter_string_get(filter, item);
+
+    // Items without a string are always shown
+    if (!string || tui_string_query_find(string, filter->_query, level))
+    {
+      filter->matches[match_count++] = item;
+    }
   }
 
-  tui_input_string_update(input);
+  filter->_levels[level] = match_count;
 
-  return true;
+  return 0;
 }
 
 /*
- * Handle keypress in input window
+ * Show the items that match the query of filter
+ *
+ * A virtual list only has rows for the matches,
+ * and the items that don't match in a list of windows are hidden
  */
-bool tui_input_event(tui_input_t* input, int key)
+static inline void tui_filter_list_update(tui_filter_t* filter)
 {
-  switch (key)
+  tui_list_t* list = filter->list;
+
+  size_t  level   = filter->_query_len;
+  size_t* matches = level ? filter->matches + filter->_levels[level - 1] : NULL;
+
+  size_t count = level ? (filter->_levels[level] - filter->_levels[level - 1]) : filter->item_count;
+
+  if (list->row)
   {
-    case KEY_RIGHT:
-      return tui_input_scroll_right(input);
+    list->indexes    = matches;
+    list->item_index = 0;
+    list->scroll     = 0;
 
-    case KEY_LEFT:
-      return tui_input_scroll_left(input);
+    tui_list_count_set(list, count);
 
-    case KEY_BACKSPACE:
-      return tui_input_symbol_del(input);
-    
-    default:
-      return tui_input_symbol_add(input, key);
+    return;
   }
 
-  return false;
-}
-
-/*
- * Add item to list
- */
-int tui_list_item_add(tui_list_t* list, tui_window_t* item)
-{
-  tui_window_t** temp_items = realloc(list->items, sizeof(tui_window_t*) * (list->item_count + 1));
+  // The matches are in the same order as the items
+  size_t match_index = 0;
 
-  if (!temp_items)
+  for (size_t index = 0; index < list->item_count; index++)
   {
-    return 1;
-  }
+    bool is_match = !matches || (match_index < count && matches[match_index] == index);
 
-  list->items = temp_items;
+    if (is_match)
+    {
+      match_index++;
+    }
 
-  list->items[list->item_count++] = item;
+    if (list->items[index])
+    {
+      list->items[index]->is_hidden = !is_match;
+    }
+  }
 
-  return 0;
+  if (count > 0)
+  {
+    list->item_index = matches ? matches[0] : 0;
+  }
 }
 
 /*
- * Update list item by changing to another if it is invisable
+ * Update filter with the text of its input
+ *
+ * Only the matches of the part of the query that has changed are searched
  *
  * RETURN (bool changed)
  */
-bool tui_list_item_update(tui_list_t* list)
+bool tui_filter_update(tui_filter_t* filter)
 {
-  tui_window_t* item = list->items[list->item_index];
+  if (!filter) return false;
 
-  if (!item->_is_visable)
-  {
-    for (size_t index = list->item_index + 1; index < list->item_count; index++)
-    {
-      item = list->items[index];
+  char* query = tui_input_buffer_get(filter->input);
 
-      if (item->_is_visable)
-      {
-        list->item_index = index;
+  size_t query_len = strlen(query);
 
-        return true;
-      }
+  // The matches of the shared start of the queries are still valid
+  size_t level = 0;
+
+  if (!filter->_is_dirty)
+  {
+    while (level < query_len && level < filter->_query_len &&
+           tolower((unsigned char) query[level]) == tolower((unsigned char) filter->_query[level]))
+    {
+      level++;
     }
 
-    for (size_t index = list->item_index; index-- > 0;)
+    if (level == query_len && level == filter->_query_len)
     {
-      item = list->items[index];
+      return false;
+    }
+  }
 
-      if (item->_is_visable)
-      {
-        list->item_index = index;
+  memcpy(filter->_query, query, query_len);
 
-        return true;
-      }
+  filter->_query[query_len] = '\0';
+
+  for (; level < query_len; level++)
+  {
+    if (tui_filter_level_match(filter, level + 1) != 0)
+    {
+      break;
     }
   }
 
-  return false;
+  filter->_query_len = level;
+
+  filter->_is_dirty = false;
+
+  tui_filter_list_update(filter);
+
+  return true;
 }
 
 /*
- * Create list struct
+ * Create filter struct, that filters list by the text of input
+ *
+ * The string callback is needed for virtual lists
  */
-tui_list_t* tui_list_create(tui_t* tui, bool is_vertical)
+tui_filter_t* tui_filter_create(tui_t* tui, tui_list_t* list, tui_input_t* input, tui_list_string_t string)
 {
-  tui_list_t* list = malloc(sizeof(tui_list_t));
+  if (!list || !input || (list->row && !string))
+  {
+    return NULL;
+  }
 
-  if (!list)
+  TUI_STATS_ADD(alloc_count, 1);
+
+  tui_filter_t* filter = malloc(sizeof(tui_filter_t));
+
+  if (!filter)
   {
     return NULL;
   }
 
-  memset(list, 0, sizeof(tui_list_t));
+  memset(filter, 0, sizeof(tui_filter_t));
 
-  *list = (tui_list_t)
+  TUI_STATS_ADD(alloc_count, 2);
+
+  char* query = malloc(sizeof(char) * (input->buffer_size + 1));
+
+  size_t* levels = malloc(sizeof(size_t) * (input->buffer_size + 1));
+
+  if (!query || !levels)
   {
-    .is_vertical = is_vertical,
-    .tui         = tui,
+    free(query);
+
+    free(levels);
+
+    free(filter);
+
+    return NULL;
+  }
+
+  levels[0] = 0;
+
+  *filter = (tui_filter_t)
+  {
+    .list       = list,
+    .input      = input,
+    .string     = string,
+    .item_count = list->item_count,
+    ._levels    = levels,
+    ._query     = query,
+    ._is_dirty  = true,
+    .tui        = tui,
   };
 
-  return list;
+  tui_filter_update(filter);
+
+  return filter;
 }
 
 /*
- * Delete list struct
+ * Set amount of items in list of filter, and match every item again
  */
-void tui_list_delete(tui_list_t** list)
+void tui_filter_count_set(tui_filter_t* filter, size_t count)
 {
-  if (!list || !(*list)) return;
+  if (!filter) return;
 
-  free((*list)->items);
+  filter->item_count = count;
 
-  free(*list);
+  filter->_is_dirty = true;
 
-  *list = NULL;
+  tui_filter_update(filter);
 }
 
 /*
- * Scroll forward to next selected item
+ * Delete filter struct
+ *
+ * Every item of the list is shown again
  */
-static inline bool tui_list_scroll_forward(tui_list_t* list)
+void tui_filter_delete(tui_filter_t** filter)
 {
-  for (size_t index = list->item_index + 1; index < list->item_count; index++)
-  {
-    tui_window_t* window = list->items[index];
+  if (!filter || !(*filter)) return;
 
-    if (window && window->_is_visable)
-    {
-      list->item_index = index;
+  (*filter)->_query_len = 0;
 
-      return true;
-    }
-  }
+  tui_filter_list_update(*filter);
 
-  return false;
-}
+  free((*filter)->matches);
 
-/*
- * Scroll backwards to next selected item
- */
-static inline bool tui_list_scroll_backward(tui_list_t* list)
-{
-  for (size_t index = list->item_index; index-- > 0;)
-  {
-    tui_window_t* window = list->items[index];
+  free((*filter)->_levels);
 
-    if (window && window->_is_visable)
-    {
-      list->item_index = index;
+  free((*filter)->_query);
 
-      return true;
-    }
-  }
+  free(*filter);
 
-  return false;
+  *filter = NULL;
 }
 
 /*
- * Handle list event
+ * Handle filter event
+ *
+ * The keys of the list move the selection,
+ * and the other keys change the text of the input
  */
-bool tui_list_event(tui_list_t* list, int key)
+bool tui_filter_event(tui_filter_t* filter, int key)
 {
-  if (list->is_vertical)
+  if (tui_list_event(filter->list, key))
   {
-    switch (key)
-    {
-      case KEY_DOWN: case KEY_TAB:
-        return tui_list_scroll_forward(list);
-
-      case KEY_UP: case KEY_RTAB:
-        return tui_list_scroll_backward(list);
-
-      default:
-        break;
-    }
+    return true;
   }
-  else
-  {
-    switch (key)
-    {
-      case KEY_RIGHT: case KEY_TAB:
-        return tui_list_scroll_forward(list);
 
-      case KEY_LEFT: case KEY_RTAB:
-        return tui_list_scroll_backward(list);
+  if (tui_input_event(filter->input, key))
+  {
+    tui_filter_update(filter);
 
-      default:
-        break;
-    }
+    return true;
   }
 
   return false;
@@ -3601,22 +9580,82 @@ void tui_window_set(tui_t* tui, tui_window_t* window)
 
   tui->window = window;
 
+  // Both windows may look different when active and inactive
+  if (prev_window)
+  {
+    tui_window_tree_dirty_set(prev_window);
+  }
+
+  if (window)
+  {
+    tui_window_tree_dirty_set(window);
+  }
+
   // 1. Call exit event for previous window, if it exists
   if (prev_window && prev_window->event.exit)
   {
     prev_window->event.exit(prev_window);
   }
 
-  // 2. Call enter event for new window, if it exists
-  if (window && window->event.enter)
+  // 2. Call enter event for new window, if it exists
+  if (window && window->event.enter)
+  {
+    window->event.enter(window);
+  }
+
+  // 3. Set menu to window's menu, if it exists
+  if (window && window->menu)
+  {
+    tui_menu_set(tui, window->menu);
+  }
+}
+
+/*
+ * Release ncurses WINDOW* of window and its children
+ *
+ * The rects of the children are calculated again,
+ * so the WINDOWs are allocated again when the window is visable
+ */
+static inline void tui_window_ncurses_release(tui_window_t* window)
+{
+  tui_ncurses_window_release(window->tui, &window->window);
+
+  window->_is_shared = false;
+
+  if (window->type == TUI_WINDOW_PARENT)
+  {
+    tui_window_parent_t* parent = (tui_window_parent_t*) window;
+
+    parent->_layout.rect = TUI_RECT_NONE;
+
+    for (size_t index = 0; index < parent->child_count; index++)
+    {
+      tui_window_ncurses_release(parent->children[index]);
+    }
+  }
+}
+
+/*
+ * Release ncurses WINDOWs of the menus that have not been active
+ * for TUI_MENU_KEEP menu switches
+ *
+ * When the menu is active again, the WINDOWs are allocated again,
+ * from the pool of unused WINDOWs if possible
+ */
+static inline void tui_menus_release(tui_t* tui)
+{
+  for (size_t index = 0; index < tui->menu_count; index++)
   {
-    window->event.enter(window);
-  }
+    tui_menu_t* menu = tui->menus[index];
 
-  // 3. Set menu to window's menu, if it exists
-  if (window && window->menu)
-  {
-    tui_menu_set(tui, window->menu);
+    if (menu != tui->menu &&
+        tui->_menu_switch - menu->_exit_switch == TUI_MENU_KEEP)
+    {
+      for (size_t count = 0; count < menu->window_count; count++)
+      {
+        tui_window_ncurses_release(menu->windows[count]);
+      }
+    }
   }
 }
 
@@ -3636,6 +9675,20 @@ void tui_menu_set(tui_t* tui, tui_menu_t* menu)
 
   tui->menu = menu;
 
+  tui->_menu_switch++;
+
+  if (prev_menu)
+  {
+    prev_menu->_exit_switch = tui->_menu_switch;
+  }
+
+  tui_menus_release(tui);
+
+  tui_dirty_set(tui);
+
+  // Windows in the new menu may have been changed while inactive
+  tui->_layout_gen++;
+
   // 1. Call exit event for previous menu, if it exists
   if (prev_menu && prev_menu->event.exit)
   {
@@ -3676,7 +9729,7 @@ typedef struct tui_menu_config_t
  */
 tui_menu_t* tui_menu_create(tui_t* tui, tui_menu_config_t config)
 {
-  tui_menu_t* menu = malloc(sizeof(tui_menu_t));
+  tui_menu_t* menu = tui_arena_alloc(tui, sizeof(tui_menu_t));
 
   if (!menu)
   {
@@ -3691,16 +9744,25 @@ tui_menu_t* tui_menu_create(tui_t* tui, tui_menu_config_t config)
     .tui   = tui,
   };
 
-  tui_menu_t** temp_menus = realloc(tui->menus, sizeof(tui_menu_t) * (tui->menu_count + 1));
-
-  if (!temp_menus)
+  if (tui->menu_count >= tui->menu_size)
   {
-    free(menu);
+    size_t menu_size = MAX(4, tui->menu_size * 2);
 
-    return NULL;
-  }
+    TUI_STATS_ADD(alloc_count, 1);
+
+    tui_menu_t** temp_menus = realloc(tui->menus, sizeof(tui_menu_t*) * menu_size);
+
+    if (!temp_menus)
+    {
+      tui_arena_free(tui, menu);
+
+      return NULL;
+    }
+
+    tui->menus = temp_menus;
 
-  tui->menus = temp_menus;
+    tui->menu_size = menu_size;
+  }
 
   tui->menus[tui->menu_count++] = menu;
 
@@ -3746,23 +9808,188 @@ static inline void tui_1st_window_set(tui_t* tui)
 }
 
 /*
- * Start tui - main loop
+ * Get monotonic time in milliseconds
  */
-void tui_start(tui_t* tui)
+static inline int64_t tui_time_get(void)
 {
-  tui->is_running = true;
+  struct timespec time;
 
-  // If no window is active, activate 1st window
-  if (!tui->window)
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return (int64_t) time.tv_sec * 1000 + time.tv_nsec / 1000000;
+}
+
+/*
+ * Add timer to tui, that triggers event after ms milliseconds
+ *
+ * If is_repeat, the event is triggered every ms milliseconds
+ *
+ * Return id of timer, or -1 if it failed
+ */
+int tui_timer_add(tui_t* tui, int ms, bool is_repeat, void (*event) (tui_t*, void*), void* data)
+{
+  if (!event || ms < 0)
   {
-    tui_1st_window_set(tui);
+    return -1;
   }
 
-  tui_render(tui);
+  TUI_STATS_ADD(alloc_count, 1);
+
+  tui_timer_t* timers = realloc(tui->timers, sizeof(tui_timer_t) * (tui->timer_count + 1));
+
+  if (!timers)
+  {
+    return -1;
+  }
+
+  tui->timers = timers;
+
+  tui->timers[tui->timer_count++] = (tui_timer_t)
+  {
+    .id        = ++tui->_timer_id,
+    .ms        = ms,
+    .is_repeat = is_repeat,
+    ._time     = tui_time_get() + ms,
+    .event     = event,
+    .data      = data
+  };
+
+  return tui->_timer_id;
+}
+
+/*
+ * Remove timer with id from tui
+ */
+void tui_timer_remove(tui_t* tui, int id)
+{
+  for (size_t index = 0; index < tui->timer_count; index++)
+  {
+    if (tui->timers[index].id == id)
+    {
+      memmove(tui->timers + index, tui->timers + index + 1, sizeof(tui_timer_t) * (tui->timer_count - index - 1));
+
+      tui->timer_count--;
+
+      break;
+    }
+  }
+}
+
+/*
+ * Add file descriptor to tui, that triggers event when poll
+ * reports any of events, for example POLLIN
+ *
+ * Return 0 on success, else 1
+ */
+int tui_fd_add(tui_t* tui, int fd, short events, void (*event) (tui_t*, int, short, void*), void* data)
+{
+  if (fd < 0 || !event)
+  {
+    return 1;
+  }
+
+  TUI_STATS_ADD(alloc_count, 1);
+
+  tui_fd_t* fds = realloc(tui->fds, sizeof(tui_fd_t) * (tui->fd_count + 1));
+
+  if (!fds)
+  {
+    return 1;
+  }
+
+  tui->fds = fds;
+
+  tui->fds[tui->fd_count++] = (tui_fd_t)
+  {
+    .fd     = fd,
+    .events = events,
+    .event  = event,
+    .data   = data
+  };
+
+  return 0;
+}
+
+/*
+ * Remove file descriptor from tui
+ */
+void tui_fd_remove(tui_t* tui, int fd)
+{
+  for (size_t index = 0; index < tui->fd_count; index++)
+  {
+    if (tui->fds[index].fd == fd)
+    {
+      memmove(tui->fds + index, tui->fds + index + 1, sizeof(tui_fd_t) * (tui->fd_count - index - 1));
+
+      tui->fd_count--;
+
+      break;
+    }
+  }
+}
+
+/*
+ * Get milliseconds until the next timer triggers, or -1 if no timer
+ */
+static inline int tui_timers_timeout_get(tui_t* tui, int64_t time)
+{
+  int timeout = -1;
+
+  for (size_t index = 0; index < tui->timer_count; index++)
+  {
+    int64_t left = MAX(0, tui->timers[index]._time - time);
+
+    if (timeout == -1 || left < timeout)
+    {
+      timeout = MIN(left, INT32_MAX);
+    }
+  }
+
+  return timeout;
+}
+
+/*
+ * Trigger the events of the timers that are due
+ *
+ * A timer that is not repeated is removed before its event is triggered
+ */
+static inline void tui_timers_trigger(tui_t* tui, int64_t time)
+{
+  for (size_t index = 0; index < tui->timer_count;)
+  {
+    tui_timer_t timer = tui->timers[index];
+
+    if (timer._time > time)
+    {
+      index++;
+
+      continue;
+    }
+
+    if (timer.is_repeat)
+    {
+      // Skip triggers that were missed
+      tui->timers[index]._time = MAX(timer._time + timer.ms, time + 1);
+
+      index++;
+    }
+    else
+    {
+      tui_timer_remove(tui, timer.id);
+    }
+
+    timer.event(tui, timer.data);
+  }
+}
 
+/*
+ * Handle all keys that are pending, without waiting
+ */
+static inline void tui_keys_handle(tui_t* tui)
+{
   int key;
 
-  while (tui->is_running && (key = wgetch(stdscr)))
+  while (tui->is_running && (key = wgetch(stdscr)) != ERR)
   {
     if (key == KEY_CTRLC)
     {
@@ -3777,9 +10004,144 @@ void tui_start(tui_t* tui)
     }
 
     tui_event(tui, key);
+  }
+}
+
+/*
+ * Wait until a key is pressed, a file descriptor is ready or a timer is due,
+ * and then trigger all events that are ready
+ *
+ * poll waits at most timeout milliseconds, or forever if timeout is -1
+ */
+static inline void tui_poll(tui_t* tui, int timeout)
+{
+  size_t count = tui->fd_count + 2;
+
+  struct pollfd pollfds[count];
+
+  // Keys are read from stdin
+  pollfds[0] = (struct pollfd) { .fd = STDIN_FILENO, .events = POLLIN };
+
+  // Other threads wake the loop when commands are queued
+  pollfds[1] = (struct pollfd) { .fd = tui->_wake_fds[0], .events = POLLIN };
+
+  for (size_t index = 2; index < count; index++)
+  {
+    tui_fd_t fd = tui->fds[index - 2];
+
+    pollfds[index] = (struct pollfd) { .fd = fd.fd, .events = fd.events };
+  }
+
+  int timer_timeout = tui_timers_timeout_get(tui, tui_time_get());
+
+  if (timeout == -1 || (timer_timeout != -1 && timer_timeout < timeout))
+  {
+    timeout = timer_timeout;
+  }
+
+  // On a signal, like the resize signal, poll is interrupted
+  if (poll(pollfds, count, timeout) == -1 && errno != EINTR)
+  {
+    return;
+  }
+
+  // Empty the wake pipe, the commands are applied before render
+  if (pollfds[1].revents)
+  {
+    char bytes[64];
+
+    while (read(tui->_wake_fds[0], bytes, sizeof(bytes)) > 0);
+  }
+
+  // The events can add and remove file descriptors,
+  // therefore they are searched for again
+  for (size_t index = 2; index < count && tui->is_running; index++)
+  {
+    struct pollfd pollfd = pollfds[index];
+
+    if (!pollfd.revents) continue;
+
+    for (size_t fd_index = 0; fd_index < tui->fd_count; fd_index++)
+    {
+      tui_fd_t fd = tui->fds[fd_index];
+
+      if (fd.fd == pollfd.fd)
+      {
+        fd.event(tui, fd.fd, pollfd.revents, fd.data);
+
+        break;
+      }
+    }
+  }
+
+  tui_timers_trigger(tui, tui_time_get());
+
+  tui_keys_handle(tui);
+}
+
+/*
+ * Render tui and show it on the screen
+ */
+static inline void tui_frame_render(tui_t* tui)
+{
+  tui_render(tui);
+
+  tui_present(tui);
+
+  tui->_render_time = tui_time_get();
+}
 
-    tui_render(tui);
+/*
+ * Start tui - main loop
+ *
+ * The loop waits for keys, file descriptors and timers,
+ * and the tui is rendered once after every wakeup
+ *
+ * If fps is set, renders are held back until the next frame,
+ * and the events in between are rendered together
+ */
+void tui_start(tui_t* tui)
+{
+  tui->is_running = true;
+
+  // If no window is active, activate 1st window
+  if (!tui->window)
+  {
+    tui_1st_window_set(tui);
+  }
+
+  tui_frame_render(tui);
+
+  // Keys are only read when they are pending
+  nodelay(stdscr, TRUE);
+
+  int64_t frame_ms = tui->fps > 0 ? 1000 / tui->fps : 0;
+
+  bool is_pending = false;
+
+  while (tui->is_running)
+  {
+    // If a render is held back, wait at most until the next frame
+    int timeout = -1;
+
+    if (is_pending)
+    {
+      timeout = MAX(0, tui->_render_time + frame_ms - tui_time_get());
+    }
+
+    tui_poll(tui, timeout);
+
+    is_pending = true;
+
+    if (tui_time_get() - tui->_render_time >= frame_ms)
+    {
+      tui_frame_render(tui);
+
+      is_pending = false;
+    }
   }
+
+  nodelay(stdscr, FALSE);
 }
 
 /*
@@ -4040,6 +10402,42 @@ bool tui_tab_event(tui_t* tui, int key)
 
 tui_window_t* tui_window_window_search(tui_window_t* window, char* search);
 
+/*
+ * Set name of window, and update the index of windows by name
+ *
+ * The name is not copied, like the name in the config of the window
+ */
+int tui_window_name_set(tui_window_t* window, char* name)
+{
+  if (!window) return 1;
+
+  tui_index_t* index = &window->tui->_index;
+
+  tui_index_window_remove(index, window);
+
+  window->name = name;
+
+  return tui_index_window_add(index, window);
+}
+
+/*
+ * Search for window in the windows of scope, using the index
+ *
+ * scope is the parent window, menu or tui that the windows are in
+ */
+static inline tui_window_t* tui_scope_window_search(tui_t* tui, void* scope, char* search)
+{
+  char* rest = strchr(search, ' ');
+
+  size_t length = rest ? (size_t) (rest - search) : strlen(search);
+
+  tui_window_t* window = tui_index_window_get(&tui->_index, scope, search, length);
+
+  if (!window || !rest) return window;
+
+  return tui_window_window_search(window, rest + 1);
+}
+
 /*
  * Search for window in array of windows and children
  */
@@ -4080,7 +10478,7 @@ tui_window_t* tui_window_search(tui_t* tui, char* search)
     return NULL;
   }
 
-  return tui_windows_window_search(tui->windows, tui->window_count, search);
+  return tui_scope_window_search(tui, tui, search);
 }
 
 /*
@@ -4097,7 +10495,7 @@ tui_window_t* tui_menu_window_search(tui_menu_t* menu, char* search)
     return NULL;
   }
 
-  return tui_windows_window_search(menu->windows, menu->window_count, search);
+  return tui_scope_window_search(menu->tui, menu, search);
 }
 
 /*
@@ -4134,9 +10532,7 @@ tui_window_t* tui_window_window_search(tui_window_t* window, char* search)
   }
   else if (window->type == TUI_WINDOW_PARENT)
   {
-    tui_window_parent_t* parent = (tui_window_parent_t*) window;
-
-    return tui_windows_window_search(parent->children, parent->child_count, search);
+    return tui_scope_window_search(window->tui, window, search);
   }
   
   return NULL;
@@ -4187,6 +10583,21 @@ tui_window_grid_t* tui_window_window_grid_search(tui_window_t* base, char* searc
   return NULL;
 }
 
+/*
+ * Search for log window from base window
+ */
+tui_window_log_t* tui_window_window_log_search(tui_window_t* base, char* search)
+{
+  tui_window_t* window = tui_window_window_search(base, search);
+
+  if (window && window->type == TUI_WINDOW_LOG)
+  {
+    return (tui_window_log_t*) window;
+  }
+
+  return NULL;
+}
+
 /*
  * Search for window in menu and set it to active window
  */